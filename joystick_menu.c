@@ -10,13 +10,25 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <sys/wait.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <errno.h>
+#ifdef HAVE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+#ifdef HAVE_LIBURING
+#include <linux/stat.h>
+#include <liburing.h>
+#endif
 
 static Mix_Music *music = NULL;
 static SDL_Window *window = NULL;
 static SDL_Renderer *renderer = NULL;
 static SDL_Texture *logo_texture = NULL;
 static SDL_Texture *background_texture = NULL;
-static SDL_Texture *cover_texture = NULL;
+static SDL_Texture *placeholder_texture = NULL;   // shared by every ROM without a cover
+static SDL_Texture *static_layer = NULL;   // background, logo and signature composited once per window size
+static int static_layer_dirty = 1;
 static TTF_Font *font = NULL;
 
 #define INPUT_COOLDOWN_MS 200
@@ -24,8 +36,269 @@ static TTF_Font *font = NULL;
 #define LOGO_HEIGHT 200
 #define FONT_SIZE 18
 
+// Glyph atlas: every glyph is rasterized once into a single texture and strings are drawn as quads from it
+#define GLYPH_ATLAS_SIZE 512
+#define GLYPH_CACHE_SLOTS 1024 // power of two, open addressing on the codepoint
+#define GLYPH_PADDING 1
+
+typedef struct {
+    Uint32 codepoint;   // 0 marks an empty slot
+    SDL_FRect src;      // glyph cell inside the atlas
+    int xoff;           // offset of the cell relative to the pen position
+    int advance;
+} Glyph;
+
+static SDL_Texture *glyph_atlas = NULL;
+static Glyph glyph_cache[GLYPH_CACHE_SLOTS];
+static int atlas_pen_x = 0, atlas_pen_y = 0, atlas_row_h = 0;
+static int atlas_full = 0;
+
+// Cover cache: cover textures keyed by ROM path, evicted LRU once the estimated VRAM budget is exceeded
+#define COVER_CACHE_ENTRIES 256
+#define COVER_BUDGET_MB_DEFAULT 32
+#define COVER_BUDGET_MB_MIN 4   // below this covers would be evicted as soon as they are uploaded
+#define COVER_SIZE 220          // covers are drawn as a COVER_SIZE x COVER_SIZE square
+#define COVER_LEVELS 3          // level n is COVER_SIZE >> n square: 220, 110 and 55
+
+// Thumbnail cache: covers pre-scaled to COVER_SIZE and stored as raw pixels that need no decoding
+#define THUMB_DIR "./covers/.thumbs"
+#define THUMB_MAGIC 0x31544D4Au // "JMT1"
+#define THUMB_MAX_DIM 4096
+#define THUMB_HEADER_SIZE 32
+
+// Cover pack: every thumbnail in one file behind a hash-sorted index, mapped once at startup
+#define PACK_PATH "./covers/covers.pack"
+#define PACK_MAGIC 0x31504D4Au // "JMP1"
+#define PACK_HEADER_SIZE 32
+#define PACK_ALIGN 16
+
+typedef struct CoverRequest CoverRequest;
+
+typedef struct {
+    char *rom_path;     // NULL marks a free entry
+    Uint32 hash;
+    int level;          // each resolution level of a cover is its own entry
+    SDL_Texture *texture;   // NULL while decoding or for a ROM known to have no cover
+    CoverRequest *request;  // decode in flight
+    size_t bytes;
+    Uint64 last_used;
+    Uint64 last_frame;
+} CoverEntry;
+
+// A decode handed to a worker; it always comes back through cover_done so the main thread frees it
+struct CoverRequest {
+    char *rom_path;
+    int level;
+    CoverEntry *entry;
+    SDL_AtomicInt cancelled;
+    int decoded;
+    SDL_Surface *surface;   // ARGB8888, ready to upload; NULL if the ROM has no cover
+    Uint64 decode_ns;
+    CoverRequest *next;
+};
+
+static CoverEntry cover_cache[COVER_CACHE_ENTRIES];
+static size_t cover_cache_bytes = 0;
+static size_t cover_budget_bytes = (size_t)COVER_BUDGET_MB_DEFAULT * 1024 * 1024;
+static Uint64 cover_clock = 0;
+static Uint64 cover_hits = 0, cover_misses = 0, cover_evictions = 0, cover_cancelled = 0, cover_prefetches = 0;
+static SDL_Mutex *cover_done_mutex = NULL;
+static CoverRequest *cover_done = NULL;
+
+// Upload budget: finished decodes queue on the main thread and only this much of the queue
+// becomes textures per frame, so a burst of decodes cannot stall one frame
+#define UPLOAD_MAX_PER_FRAME 4
+#define UPLOAD_MAX_KB_PER_FRAME 512
+
+static CoverRequest *upload_head = NULL, *upload_tail = NULL;
+static int upload_backlog = 0, upload_backlog_peak = 0;
+
+// On-disk layout, little-endian: header, thumbnail records (THUMB_MAGIC format, PACK_ALIGN
+// aligned), the basename strings, then the index sorted by (hash, name)
+typedef struct {
+    Uint32 hash;
+    Uint32 name_offset;
+    Uint32 name_len;
+    Uint32 data_size;
+    Uint64 data_offset;
+} PackIndexEntry;
+
+static const Uint8 *cover_pack = NULL;
+static size_t cover_pack_size = 0;
+static const PackIndexEntry *cover_pack_index = NULL;
+static Uint32 cover_pack_count = 0;
+static const char *cover_pack_strings = NULL;
+static Uint64 cover_pack_strings_size = 0;
+
+// Cover index: ./covers listed once into a hash map by basename and rescanned only when the
+// directory's mtime moves, so a ROM without art costs a hash probe instead of stat calls
+typedef enum { COVER_FORMAT_PNG, COVER_FORMAT_JPG } CoverFormat;   // lower wins for the same basename
+
+typedef struct {
+    char *file_name;    // NULL marks a free slot
+    Uint32 hash;
+    int base_len;
+    CoverFormat format;
+    Sint64 mtime;
+    Sint64 size;
+} CoverFile;
+
+static CoverFile *cover_files = NULL;
+static Uint32 cover_files_capacity = 0;    // power of two, at least twice cover_file_count
+static Uint32 cover_file_count = 0;
+static Sint64 cover_dir_mtime = -1;        // ns; -1 until a scan can be trusted; only touched by the index job
+static SDL_RWLock *cover_files_lock = NULL;
+static SDL_AtomicInt cover_index_busy;      // an index job is queued or running
+static SDL_AtomicInt cover_index_changed;   // set by the index job after a swap, cleared by the main thread
+
+// Worker pool: jobs run on background threads, results are handed back to the main thread by each job
+#define WORKER_THREADS_MAX 8
+
+typedef void (*JobFn)(void *userdata);
+
+typedef struct Job {
+    JobFn run;
+    JobFn discard;      // called instead of run when the pool shuts down first, may be NULL
+    void *userdata;
+    int background;     // taken from the background queue
+    struct Job *next;
+} Job;
+
+static SDL_Thread *workers[WORKER_THREADS_MAX];
+static int worker_count = 0;
+static SDL_Mutex *job_mutex = NULL;
+static SDL_Condition *job_cond = NULL;
+static Job *job_head = NULL, *job_tail = NULL;
+// Background jobs only run when no interactive job is queued, and never on every worker at once,
+// so a long pre-scan cannot hold up the system the user just entered or the covers on screen
+static Job *background_head = NULL, *background_tail = NULL;
+static int background_running = 0;
+static int background_limit = 0;
+static int workers_quit = 0;
+
+// Label cache: whole strings composed from the glyph atlas into rows of one target texture, evicted LRU
+#define LABEL_CACHE_SLOTS 64
+#define LABEL_SLOT_W 1024
+#define LABEL_TEXT_MAX 256
+
+typedef struct {
+    char text[LABEL_TEXT_MAX];
+    Uint32 hash;
+    SDL_Color color;
+    int font_size;
+    int w;
+    int in_use;
+    Uint64 last_used;
+} LabelEntry;
+
+static SDL_Texture *label_texture = NULL;
+static LabelEntry label_cache[LABEL_CACHE_SLOTS];
+static int label_slot_h = 0;
+static Uint64 label_clock = 0;
+static Uint64 label_hits = 0, label_misses = 0, label_evictions = 0;
+
+// Render batch: quads are grouped per texture and submitted with one SDL_RenderGeometry call each.
+// Buckets are flushed in first-use order, so callers flush before drawing over a different texture.
+#define BATCH_MAX_BUCKETS 8
+
+typedef struct {
+    SDL_Texture *texture;   // NULL for solid color fills
+    float tex_w, tex_h;
+    SDL_Vertex *verts;
+    int *indices;
+    int quad_count;
+    int quad_capacity;
+} BatchBucket;
+
+static BatchBucket batch_buckets[BATCH_MAX_BUCKETS];
+static int batch_bucket_count = 0;
+
 static Uint64 last_input_time = 0;
 
+// Redraw scheduler: the loop sleeps in SDL_WaitEventTimeout until something invalidates the frame
+static int frame_dirty = 1;
+static Uint64 frame_serial = 0;         // incremented at the start of every rendered frame
+static Uint64 redraw_deadline = 0;      // SDL_GetTicks() time an animation wants its next frame, 0 if none
+static Uint32 wake_event_type = 0;      // pushed by background jobs when they finish
+static Uint64 last_frame_ns = 0;
+static Uint64 frames_rendered = 0, frames_skipped = 0;
+
+// Frame pacing: vsync when the renderer supports it, otherwise a deadline-based sleep
+#define DEFAULT_REFRESH_HZ 60
+#define PRESENT_RESERVE_NS (2 * SDL_NS_PER_MS)  // kept free for the final flush and present
+
+static int vsync_enabled = 0;
+static Uint64 frame_period_ns = SDL_NS_PER_SECOND / DEFAULT_REFRESH_HZ;
+static Uint64 frame_start_ns = 0;
+static Uint64 next_frame_ns = 0;
+
+// Frame-time HUD: rolling histogram of the last frames plus per-phase timings of the main loop
+#define HUD_HISTORY 240
+#define HUD_BIN_NS (250 * SDL_NS_PER_US)   // histogram resolution
+#define HUD_BINS 256                        // 64 ms range, the last bin also collects slower frames
+#define HUD_REFRESH_MS 500
+#define HUD_COMBO_BUTTON_A 6                // select + start toggles the HUD from a joystick
+#define HUD_COMBO_BUTTON_B 7
+
+typedef struct {
+    Uint64 start_ns;
+    int bin;
+} HudSample;
+
+static int hud_visible = 0;
+static HudSample hud_history[HUD_HISTORY];
+static int hud_history_pos = 0, hud_history_len = 0;
+static Uint32 hud_bins[HUD_BINS];
+static Uint64 hud_event_ns = 0, hud_draw_ns = 0, hud_present_ns = 0;
+static Uint64 pending_event_ns = 0;         // event handling since the last rendered frame
+static Uint64 textures_created = 0, hud_textures_mark = 0;
+static int hud_textures_per_frame = 0;
+static Uint64 draw_calls = 0, hud_draw_calls_mark = 0;
+static int hud_draw_calls_per_frame = 0;
+
+// Headless benchmark: scripted joystick input on the offscreen/dummy video driver and the software renderer
+#define BENCH_ROM_STEPS 60
+
+typedef struct {
+    Uint64 ns;
+    Uint32 calls;
+} ProfileCounter;
+
+typedef enum {
+    BENCH_UP,
+    BENCH_DOWN,
+    BENCH_PRESS,
+    BENCH_LEAVE_ROMS,   // move up to the ROM list "Exit" entry and press it
+} BenchAction;
+
+static int bench_mode = 0;
+static ProfileCounter prof_load_rom_list = { 0, 0 };
+static ProfileCounter prof_load_cover = { 0, 0 };
+
+// Tracing: spans go into a ring buffer per thread and are dumped as Chrome trace-event JSON
+#define TRACE_RING_EVENTS 16384
+#define TRACE_MAX_THREADS 16
+
+typedef struct {
+    const char *name;
+    Uint64 start_ns;
+    Uint64 dur_ns;
+} TraceEvent;
+
+typedef struct {
+    SDL_ThreadID tid;
+    char thread_name[32];
+    SDL_SpinLock lock;
+    Uint32 head, count;
+    TraceEvent events[TRACE_RING_EVENTS];
+} TraceRing;
+
+static int trace_enabled = 0;
+static const char *trace_path = "trace.json";
+static TraceRing *trace_rings[TRACE_MAX_THREADS];
+static SDL_AtomicInt trace_ring_count;
+static SDL_TLSID trace_tls;
+
 typedef struct {
     const char *dir_name;
     const char *display_name;
@@ -50,30 +323,272 @@ static int in_rom_menu = 0;
 
 static int system_menu_count = sizeof(systems) / sizeof(SystemEntry) + 2;
 
+// ROM library index: each system's scan result is kept in LIBRARY_INDEX_DIR together with the mtime
+// of every folder it came from, so entering a system only stats those folders and rescans the changed ones
+#define LIBRARY_INDEX_DIR "./.library"
+#define LIBRARY_MAGIC 0x324C4D4Au // "JML2"
+#define LIBRARY_RACY_NS (2 * SDL_NS_PER_SECOND) // FAT keeps mtimes to 2 s, ext4 to a timer tick
+#define LIBRARY_MAX_NAME 1024
+#define SCAN_OPEN_BATCH 32        // subfolders opened ahead of being read
+#define SCAN_URING_DEPTH 64       // statx/openat requests kept in flight with liburing
+
+typedef struct {
+    char *name;         // subfolder name, "" for the system folder itself
+    Sint64 mtime;       // ns since the epoch, 0 when it was too close to the scan to be trusted
+    char **files;
+    int file_count;
+    int file_capacity;
+    int pending;        // listed but not read yet, only while a scan runs
+} RomDir;
+
+typedef struct {
+    RomDir *dirs;       // dirs[0] is the system folder whenever it exists
+    int dir_count;
+    int dir_capacity;
+    Uint32 syscalls;    // issued while loading or scanning this library
+} RomLibrary;
+
+// One directory entry during a scan; a folder is read in a single pass and then handled in inode order
+typedef struct {
+    char *name;
+    Uint64 ino;
+    int type;           // DT_* as reported, then as resolved by fstatat() or statx where that was needed
+    Sint64 mtime;       // only filled in when the entry was resolved
+} ScanEntry;
+
+// Per-scan state: the syscall count and, when built with liburing, the ring statx and openat go through
+typedef struct {
+    Uint32 syscalls;
+    Sint64 start_ns;    // wall clock when the scan started, to spot folders changed during it
+#ifdef HAVE_LIBURING
+    struct io_uring ring;
+    int ring_open;      // set up, needs io_uring_queue_exit()
+    int ring_ready;     // still usable; cleared when a submit fails
+    int ring_stuck;     // requests were left in the kernel, so statx_bufs must not be freed
+    struct statx *statx_bufs;
+#endif
+} ScanIo;
+
+static SDL_AtomicInt scan_syscalls_total;
+
+// Called by a scan with each run of new entries; returning 0 stops the scan
+typedef int (*RomEmitFn)(void *userdata, const SystemEntry *sys, const RomDir *dir, int first, int count);
+
 typedef struct {
     char *display_name;
     char *rom_path;
+    float text_w;       // measured once when the list is loaded
+    int fit_len;        // bytes shown before the ellipsis, -1 when the whole name fits
 } RomEntry;
 
 static RomEntry *rom_list = NULL;
 static int rom_count = 0;
 static int selected_rom_index = 0;
 static int rom_scroll_offset = 0;
+static float rom_layout_w = 0.0f;   // row width the fit_len values were computed for
+static int rom_scroll_direction = 1;  // last direction the selection moved, drives cover prefetching
+
+// Background ROM scan: runs as a pool job and streams entries back in batches, so the menu opens
+// at once and fills in while the folders are read
+#define ROM_SCAN_BATCH 256
+#define ROM_SCAN_GRACE_MS 16    // how long entering a system waits for a scan before showing a partial list
+
+typedef struct RomBatch {
+    RomEntry *entries;
+    int count;
+    struct RomBatch *next;
+} RomBatch;
+
+typedef struct {
+    const SystemEntry *sys;
+    SDL_AtomicInt cancelled;
+    SDL_AtomicInt refs;         // the main thread and the job hold one each, the last release frees the scan
+    SDL_Mutex *mutex;           // guards batches and finished
+    RomBatch *batches, *batches_tail;
+    int finished;
+    Uint64 start_ns;
+} RomScan;
+
+static RomScan *rom_scan = NULL;    // scan still filling rom_list, NULL once it completed
+
+// Startup pre-scan: every system is scanned on the pool right after the first frame, which warms
+// its library index and gives the system menu a game count
+static SDL_AtomicInt system_game_counts[sizeof(systems) / sizeof(SystemEntry)];  // count + 1, 0 while unknown
+static SDL_AtomicInt system_scans_active[sizeof(systems) / sizeof(SystemEntry)]; // menu scans not yet finished
+static SDL_AtomicInt prescan_quit;
+
+#define PREFETCH_AHEAD 8
+#define PREFETCH_BEHIND 2
+
+#define ROW_MARGIN 40
+#define ELLIPSIS "..."
+
+// Grid view: the ROM list as cover tiles; only visible rows and a few around them touch the cover cache
+#define GRID_TILE 110
+#define GRID_GAP 16
+#define GRID_PREFETCH_ROWS 2
+#define GRID_TOGGLE_BUTTON 3
+
+static int rom_view_grid = 0;
+static int grid_columns = 1;        // from the last drawn frame, used to step a row up or down
+static int grid_scroll_row = 0;
 
 static void draw_system_menu(void);
 static void draw_rom_menu(void);
+static void draw_rom_grid(void);
+static void move_grid_selection(int dx, int dy);
+static void draw_static_layers(int win_w, int win_h);
+static void rebuild_static_layer(int win_w, int win_h);
 static void load_rom_list(const SystemEntry *sys);
+static void start_rom_scan(const SystemEntry *sys);
+static void start_system_prescan(void);
+static void prescan_system_job(void *userdata);
+static int prescan_emit(void *userdata, const SystemEntry *sys, const RomDir *dir, int first, int count);
+static void scan_rom_job(void *userdata);
+static void discard_rom_scan_job(void *userdata);
+static int emit_rom_batch(void *userdata, const SystemEntry *sys, const RomDir *dir, int first, int count);
+static void release_rom_scan(RomScan *scan);
+static void pump_rom_scan(void);
+static void cancel_rom_scan(void);
+static void append_rom_entries(RomEntry *entries, int count);
+static void draw_scan_indicator(int win_w, int win_h);
+static RomDir *add_rom_dir(RomLibrary *lib, const char *name, Sint64 mtime);
+static int add_rom_file(RomDir *dir, const char *name);
+static void take_rom_dir(RomLibrary *lib, RomDir *src);
+static RomDir *find_rom_dir(RomLibrary *lib, const char *name, int *hint);
+static void free_rom_library(RomLibrary *lib);
+static int emit_rom_files(const SystemEntry *sys, const RomDir *dir, int first, RomEmitFn emit, void *userdata);
+static int read_scan_entries(DIR *dir, ScanEntry **entries, int *count, ScanIo *io);
+static int SDLCALL compare_scan_inodes(const void *a, const void *b);
+static void free_scan_entries(ScanEntry *entries, int count);
+static int needs_scan_stat(const ScanEntry *e, const char *allowed_exts, int want_dirs);
+static Sint64 stat_mtime_ns(const struct stat *st);
+static void stat_scan_entry(ScanIo *io, int dir_fd, ScanEntry *e);
+#ifdef HAVE_LIBURING
+static void open_scan_ring(ScanIo *io);
+static void close_scan_ring(ScanIo *io);
+static int submit_scan_ring(ScanIo *io);
+static struct io_uring_cqe *wait_scan_ring(ScanIo *io);
+static struct io_uring_cqe *next_scan_completion(ScanIo *io);
+static void resolve_scan_entries_ring(ScanIo *io, int dir_fd, ScanEntry *entries, int count,
+                                      const char *allowed_exts, int want_dirs);
+#endif
+static void resolve_scan_entries(ScanIo *io, int dir_fd, ScanEntry *entries, int count, const char *allowed_exts,
+                                 int want_dirs);
+static void open_scan_dirs(ScanIo *io, int parent_fd, RomDir **dirs, int *fds, int count);
+static int scan_rom_subdir(const SystemEntry *sys, int fd, RomDir *dir, ScanIo *io, RomEmitFn emit, void *userdata);
+static int scan_rom_subdirs(const SystemEntry *sys, int top_fd, RomLibrary *out, ScanIo *io, RomEmitFn emit, void *userdata);
+static Sint64 index_dir_mtime(const ScanIo *io, Sint64 mtime);
+static int scan_rom_library(const SystemEntry *sys, RomLibrary *cached, RomLibrary *out, ScanIo *io, RomEmitFn emit, void *userdata);
+static int refresh_rom_library(const SystemEntry *sys, RomEmitFn emit, void *userdata);
+static int read_index_string(SDL_IOStream *io, char *buf, size_t size);
+static int write_index_string(SDL_IOStream *io, const char *s);
+static void library_index_path(const SystemEntry *sys, char *path, size_t size);
+static int load_library_index(const SystemEntry *sys, RomLibrary *lib);
+static void save_library_index(const SystemEntry *sys, const RomLibrary *lib);
 static void free_rom_list(void);
+static void measure_rom_list(void);
+static void layout_rom_list(float max_w);
+static int fit_text(const char *text, float max_w);
 static void handle_events(const SDL_Event *event);
 static void handle_joystick_input(const SDL_Event *event);
+static void request_redraw(void);
+static void request_redraw_at(Uint64 when);
+static void wake_main_loop(void);
+static Sint32 next_wait_timeout(void);
+static int take_redraw(void);
+static void count_rendered_frame(void);
+static void log_frame_stats(void);
+static void init_frame_pacer(void);
+static void begin_frame(void);
+static void end_frame(void);
+static Sint64 frame_budget_ns(void);
+static void toggle_hud(void);
+static void record_frame_phases(Uint64 draw_ns, Uint64 present_ns);
+static float frame_time_percentile(float p);
+static void draw_hud(void);
+static SDL_Texture *create_texture(SDL_PixelFormat format, SDL_TextureAccess access, int w, int h);
+static SDL_Texture *load_texture(const char *path);
+static SDL_Texture *load_scaled_texture(const char *path, int target_w, int target_h);
+static void render_frame(void);
+static void profile_add(ProfileCounter *counter, Uint64 start_ns);
+static void bench_inject(BenchAction action);
+static int run_bench(void);
+static TraceRing *trace_ring_for_thread(void);
+static void trace_set_thread_name(const char *name);
+static Uint64 trace_begin(void);
+static void trace_end(const char *name, Uint64 start_ns);
+static void trace_dump(const char *path);
+static void trace_dump_at_exit(void);
 static int has_allowed_extension(const char *filename, const char *allowed_exts);
 static void render_text_centered(const char *text, float y, SDL_Color color);
 static void render_text(const char *text, float x, float y, SDL_Color color);
+static int init_glyph_atlas(void);
+static void free_glyph_atlas(void);
+static const Glyph *get_glyph(Uint32 ch);
+static const Glyph *get_glyph_or_fallback(Uint32 ch);
+static float measure_text(const char *text);
+static void draw_text_quads(const char *text, float x, float y, SDL_Color color);
+static int init_label_cache(void);
+static void clear_label_cache(void);
+static void free_label_cache(void);
+static const LabelEntry *get_label(const char *text, SDL_Color color);
+static void draw_label(const LabelEntry *label, float x, float y, SDL_Color tint);
+static BatchBucket *batch_bucket_for(SDL_Texture *texture);
+static void batch_quad(SDL_Texture *texture, const SDL_FRect *src, const SDL_FRect *dst, SDL_Color color);
+static void batch_fill(const SDL_FRect *rect, SDL_Color color);
+static void batch_flush(void);
+static void free_batch(void);
 static void draw_scrollbar(int item_count, int visible_lines, int scroll_offset, int start_y, int line_height, int win_w);
-static int file_exists(const char *path);
-static SDL_Texture *load_cover_for_rom(const char *rom_path);
+static SDL_Surface *load_cover_for_rom(const char *rom_path, int level);
+static int read_thumb_header(SDL_IOStream *io, Uint32 *w, Uint32 *h, Sint64 *mtime, Sint64 *size);
+static SDL_Surface *read_thumb(SDL_IOStream *io, Sint64 src_mtime, Sint64 src_size);
+static int write_thumb_io(SDL_IOStream *io, SDL_Surface *thumb, Sint64 src_mtime, Sint64 src_size);
+static void write_thumb(const char *thumb_path, SDL_Surface *thumb, Sint64 src_mtime, Sint64 src_size);
+static SDL_Surface *make_thumb(const char *src_path);
+static SDL_Surface *load_jpeg_scaled(const char *path, int target_w, int target_h);
+static SDL_Surface *load_thumb(const char *src_path, const char *base, int base_len, Sint64 src_mtime, Sint64 src_size);
+static void refresh_cover_index(void);
+static void cover_index_job(void *userdata);
+static void discard_cover_index_job(void *userdata);
+static void pump_cover_index(void);
+static void free_cover_index(void);
+static CoverFile *cover_file_slot(CoverFile *table, Uint32 capacity, const char *base, int base_len, Uint32 hash);
+static int find_cover_file(const char *base, int base_len, char *path, size_t path_size, Sint64 *mtime, Sint64 *size);
+static void forget_missing_covers(void);
+static int build_thumbnails(void);
+static void open_cover_pack(void);
+static void close_cover_pack(void);
+static const PackIndexEntry *find_packed_cover(const char *base, int base_len);
+static const Uint8 *packed_record(const PackIndexEntry *entry, Uint32 *data_size, Uint32 *w, Uint32 *h,
+                                  Sint64 *src_mtime, Sint64 *src_size);
+static SDL_Surface *packed_cover_surface(const PackIndexEntry *entry, Sint64 src_mtime, Sint64 src_size);
+static int SDLCALL compare_pack_entries(void *userdata, const void *a, const void *b);
+static int build_cover_pack(void);
+static void init_cover_cache(void);
+static void free_cover_entry(CoverEntry *e);
+static void free_cover_cache(void);
+static CoverEntry *lru_cover(int with_texture, const CoverEntry *keep);
+static CoverEntry *alloc_cover_entry(void);
+static void trim_covers(size_t incoming, const CoverEntry *keep);
+static int cover_level_for(float size);
+static SDL_Texture *get_cover(const char *rom_path, int level, int prefetch);
+static void prefetch_covers(int first, int last, int ahead, int behind, int level);
+static void decode_cover_job(void *userdata);
+static void discard_cover_job(void *userdata);
+static void pump_cover_uploads(void);
+static void complete_cover_request(CoverRequest *req);
+static void cancel_stale_covers(void);
+static void init_workers(void);
+static int worker_main(void *data);
+static void submit_job(JobFn run, JobFn discard, void *userdata);
+static void submit_background_job(JobFn run, JobFn discard, void *userdata);
+static void queue_job(JobFn run, JobFn discard, void *userdata, int background);
+static void shutdown_workers(void);
+static SDL_Texture *texture_from_surface(SDL_Surface *surface);
 
 static void draw_system_menu(void) {
+    Uint64 trace_start = trace_begin();
     int win_w, win_h; SDL_GetWindowSize(window, &win_w, &win_h);
     int item_count = system_menu_count;
     int line_height = FONT_SIZE + 10;
@@ -93,8 +608,14 @@ static void draw_system_menu(void) {
         if (i == selected_system_index) color.r = color.g = 255;
 
         const char *label = NULL;
+        char counted[LABEL_TEXT_MAX];
         if (i < (item_count - 2)) {
             label = systems[i].display_name;
+            int known = SDL_GetAtomicInt(&system_game_counts[i]);
+            if (known) {
+                SDL_snprintf(counted, sizeof(counted), "%s (%d)", label, known - 1);
+                label = counted;
+            }
         } else if (i == (item_count - 2)) {
             label = "Run Cover Scraper";
         } else {
@@ -104,9 +625,11 @@ static void draw_system_menu(void) {
     }
 
     draw_scrollbar(item_count, visible_lines, system_scroll_offset, start_y, line_height, win_w);
+    trace_end("draw_system_menu", trace_start);
 }
 
 static void draw_rom_menu(void) {
+    Uint64 trace_start = trace_begin();
     int win_w, win_h; SDL_GetWindowSize(window, &win_w, &win_h);
     int line_height = FONT_SIZE + 10;
     int visible_lines = (win_h - LOGO_HEIGHT - 40) / line_height;
@@ -116,6 +639,9 @@ static void draw_rom_menu(void) {
 
     int start_y = LOGO_HEIGHT + 20;
 
+    float max_w = (float)(win_w - 2 * ROW_MARGIN);
+    if (max_w != rom_layout_w) layout_rom_list(max_w);
+
     for (int i = 0; i < rom_count; ++i) {
         if (i < rom_scroll_offset) continue;
         if (i >= rom_scroll_offset + visible_lines) break;
@@ -123,44 +649,241 @@ static void draw_rom_menu(void) {
         SDL_Color color = { 200, 200, 200, 255 };
         if (i == selected_rom_index) color.r = color.g = 255;
 
-        render_text_centered(rom_list[i].display_name, start_y + (i - rom_scroll_offset) * line_height, color);
+        const char *label = rom_list[i].display_name;
+        char truncated[LABEL_TEXT_MAX];
+        if (rom_list[i].fit_len >= 0) {
+            SDL_snprintf(truncated, sizeof(truncated), "%.*s" ELLIPSIS, rom_list[i].fit_len, label);
+            label = truncated;
+        }
+
+        render_text_centered(label, start_y + (i - rom_scroll_offset) * line_height, color);
     }
 
     draw_scrollbar(rom_count, visible_lines, rom_scroll_offset, start_y, line_height, win_w);
+    if (rom_scan) draw_scan_indicator(win_w, win_h);
 
     if (rom_list && rom_list[selected_rom_index].rom_path) {
-        if (cover_texture) {
-            SDL_DestroyTexture(cover_texture);
-            cover_texture = NULL;
+        SDL_FRect dst = { win_w - 80 - 150.0f, 30 + 0.0f, (float)COVER_SIZE, (float)COVER_SIZE };
+        SDL_Texture *cover = get_cover(rom_list[selected_rom_index].rom_path, cover_level_for(dst.w), 0);
+
+        if (cover) {
+            SDL_Color white = { 255, 255, 255, 255 };
+            batch_quad(cover, NULL, &dst, white);
+        }
+    }
+
+    prefetch_covers(selected_rom_index, selected_rom_index + 1, PREFETCH_AHEAD, PREFETCH_BEHIND, cover_level_for(COVER_SIZE));
+    trace_end("draw_rom_menu", trace_start);
+}
+
+// Covers that are not decoded yet draw as the placeholder, so scrolling never waits on a decode
+static void draw_rom_grid(void) {
+    if (!rom_list || !rom_count) return;
+
+    Uint64 trace_start = trace_begin();
+    int win_w, win_h; SDL_GetWindowSize(window, &win_w, &win_h);
+    int cell = GRID_TILE + GRID_GAP;
+    int caption_h = FONT_SIZE + 10;
+    int start_y = LOGO_HEIGHT + 20;
+
+    float max_w = (float)(win_w - 2 * ROW_MARGIN);
+    if (max_w != rom_layout_w) layout_rom_list(max_w);
+
+    int columns = ((int)max_w + GRID_GAP) / cell;
+    if (columns < 1) columns = 1;
+    int visible_rows = (win_h - start_y - caption_h - 20) / cell;
+    if (visible_rows < 1) visible_rows = 1;
+    int total_rows = (rom_count + columns - 1) / columns;
+    grid_columns = columns;
+
+    int selected_row = selected_rom_index / columns;
+    if (selected_row < grid_scroll_row) grid_scroll_row = selected_row;
+    if (selected_row >= grid_scroll_row + visible_rows) grid_scroll_row = selected_row - visible_rows + 1;
+    if (grid_scroll_row > total_rows - visible_rows) grid_scroll_row = SDL_max(total_rows - visible_rows, 0);
+
+    float left = SDL_floorf((win_w - (columns * cell - GRID_GAP)) / 2.0f);
+    int first = grid_scroll_row * columns;
+    int last = SDL_min(rom_count, first + visible_rows * columns);
+    int level = cover_level_for(GRID_TILE);
+    SDL_Color white = { 255, 255, 255, 255 };
+    SDL_Color highlight = { 255, 255, 0, 255 };
+
+    // Solid fills go first and are flushed on their own: covers, the placeholder and the Exit label
+    // land in other buckets, which may have been opened before the fill bucket
+    for (int i = first; i < last; ++i) {
+        SDL_FRect dst = {
+            left + ((i - first) % columns) * cell, (float)(start_y + ((i - first) / columns) * cell),
+            (float)GRID_TILE, (float)GRID_TILE
+        };
+
+        if (i == selected_rom_index) {
+            SDL_FRect frame = { dst.x - 4, dst.y - 4, dst.w + 8, dst.h + 8 };
+            batch_fill(&frame, highlight);
+        }
+        if (!rom_list[i].rom_path) {
+            SDL_Color tile_color = { 40, 40, 40, 255 };
+            batch_fill(&dst, tile_color);
+        }
+    }
+    batch_flush();
+
+    for (int i = first; i < last; ++i) {
+        SDL_FRect dst = {
+            left + ((i - first) % columns) * cell, (float)(start_y + ((i - first) / columns) * cell),
+            (float)GRID_TILE, (float)GRID_TILE
+        };
+
+        if (rom_list[i].rom_path) {
+            SDL_Texture *cover = get_cover(rom_list[i].rom_path, level, 0);
+            if (cover) batch_quad(cover, NULL, &dst, white);
+        } else {
+            SDL_Color text_color = { 200, 200, 200, 255 };
+            float text_w = measure_text(rom_list[i].display_name);
+            render_text(rom_list[i].display_name, SDL_floorf(dst.x + (dst.w - text_w) / 2.0f),
+                        SDL_floorf(dst.y + (dst.h - FONT_SIZE) / 2.0f), text_color);
         }
+    }
+
+    const RomEntry *selected = &rom_list[selected_rom_index];
+    const char *caption = selected->display_name;
+    char truncated[LABEL_TEXT_MAX];
+    if (selected->fit_len >= 0) {
+        SDL_snprintf(truncated, sizeof(truncated), "%.*s" ELLIPSIS, selected->fit_len, caption);
+        caption = truncated;
+    }
+    render_text_centered(caption, (float)(start_y + visible_rows * cell), highlight);
+
+    draw_scrollbar(total_rows, visible_rows, grid_scroll_row, start_y, cell, win_w);
+    if (rom_scan) draw_scan_indicator(win_w, win_h);
+
+    prefetch_covers(first, last, GRID_PREFETCH_ROWS * columns, columns, level);
+    trace_end("draw_rom_grid", trace_start);
+}
+
+// Left/right wraps through the list. Up/down moves a row: up from the first row lands on the
+// last entry (Exit) like the list view, down clamps into a short last row and then wraps to the top.
+static void move_grid_selection(int dx, int dy) {
+    int index = selected_rom_index;
+    if (dx) {
+        index = (index + rom_count + dx) % rom_count;
+    } else if (dy) {
+        int last_row = (rom_count - 1) / grid_columns;
+        index += dy * grid_columns;
+        if (index < 0) index = rom_count - 1;
+        else if (index >= rom_count) index = selected_rom_index / grid_columns == last_row ? selected_rom_index % grid_columns : rom_count - 1;
+    }
+    selected_rom_index = index;
+    rom_scroll_direction = (dx ? dx : dy) > 0 ? 1 : -1;
+}
+
+static void draw_static_layers(int win_w, int win_h) {
+    if (background_texture) {
+        SDL_FRect dst = { 0, 0, (float)win_w, (float)win_h };
+        SDL_Color faded = { 255, 255, 255, 80 };
+        batch_quad(background_texture, NULL, &dst, faded);
+    }
+
+    if (logo_texture) {
+        SDL_FRect dst = { (win_w - 200) / 2.0f, 40.0f, 200.0f, 100.0f };
+        SDL_Color white = { 255, 255, 255, 255 };
+        batch_quad(logo_texture, NULL, &dst, white);
+    }
+
+    SDL_Color sig_color = { 150, 150, 150, 255 };
+    render_text("by MARCO AURELIO SIMAO", 10, win_h - FONT_SIZE - 10, sig_color);
+}
 
-        cover_texture = load_cover_for_rom(rom_list[selected_rom_index].rom_path);
-        if (!cover_texture) {
-            cover_texture = IMG_LoadTexture(renderer, "assets/cover.png");
+// The static layers only change with the window size, so they are composited into an opaque
+// target once and every frame starts with a single unblended copy of it
+static void rebuild_static_layer(int win_w, int win_h) {
+    if (static_layer) {
+        float w, h;
+        SDL_GetTextureSize(static_layer, &w, &h);
+        if ((int)w != win_w || (int)h != win_h) {
+            SDL_DestroyTexture(static_layer);
+            static_layer = NULL;
         }
+    }
 
-        if (cover_texture) {
-            SDL_FRect dst = { win_w - 80 - 150.0f, 30 + 0.0f, 220.0f, 220.0f };
-            SDL_RenderTexture(renderer, cover_texture, NULL, &dst);
+    if (!static_layer) {
+        static_layer = create_texture(SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, win_w, win_h);
+        if (!static_layer) {
+            SDL_Log("Static layer disabled: %s", SDL_GetError());
+            static_layer_dirty = 0;
+            return;
         }
+        SDL_SetTextureBlendMode(static_layer, SDL_BLENDMODE_NONE);
     }
+
+    batch_flush();
+    SDL_Texture *prev_target = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, static_layer);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+    draw_static_layers(win_w, win_h);
+    batch_flush();
+    SDL_SetRenderTarget(renderer, prev_target);
+
+    static_layer_dirty = 0;
 }
 
 int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--build-thumbs") == 0) return build_thumbnails();
+        if (strcmp(argv[i], "--build-cover-pack") == 0) return build_cover_pack();
+        if (strcmp(argv[i], "--bench") == 0) bench_mode = 1;
+        if (strcmp(argv[i], "--trace") == 0) trace_enabled = 1;
+        if (strncmp(argv[i], "--cover-budget-mb=", 18) == 0) {
+            char *end;
+            long mb = SDL_strtol(argv[i] + 18, &end, 10);
+            if (end == argv[i] + 18 || *end != '\0') {
+                SDL_Log("Ignoring %s: not a number of MB", argv[i]);
+            } else {
+                if (mb < COVER_BUDGET_MB_MIN) SDL_Log("Cover budget raised to the minimum of %d MB", COVER_BUDGET_MB_MIN);
+                cover_budget_bytes = (size_t)SDL_max(mb, COVER_BUDGET_MB_MIN) * 1024 * 1024;
+            }
+        }
+        if (strncmp(argv[i], "--trace=", 8) == 0) {
+            trace_enabled = 1;
+            trace_path = argv[i] + 8;
+        }
+    }
+
+    if (trace_enabled) {
+        // atexit also covers the exit(0) taken by the menu's Exit entry
+        trace_set_thread_name("main");
+        atexit(trace_dump_at_exit);
+    }
+
+    if (bench_mode) {
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen,dummy");
+        SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    }
+
     SDL_Init(SDL_INIT_VIDEO | SDL_INIT_JOYSTICK | SDL_INIT_AUDIO);
     TTF_Init();
 
     SDL_CreateWindowAndRenderer("Joystick Menu", 1024, 768, 0, &window, &renderer);
     font = TTF_OpenFont("assets/Roboto-Regular.ttf", FONT_SIZE);
+    init_glyph_atlas();
+    init_label_cache();
 
-    logo_texture = IMG_LoadTexture(renderer, "assets/logo.png");
-    background_texture = IMG_LoadTexture(renderer, "assets/background.jpg");
+    logo_texture = load_texture("assets/logo.png");
+    // The background is stretched over the window, which can at most grow to the desktop size
+    const SDL_DisplayMode *desktop = SDL_GetDesktopDisplayMode(SDL_GetDisplayForWindow(window));
+    background_texture = load_scaled_texture("assets/background.jpg", desktop ? desktop->w : 1024, desktop ? desktop->h : 768);
 
     if (background_texture) {
         SDL_SetTextureBlendMode(background_texture, SDL_BLENDMODE_BLEND);
-        SDL_SetTextureAlphaMod(background_texture, 80);
     }
 
+    init_cover_cache();
+    mkdir(THUMB_DIR, 0755);
+    mkdir(LIBRARY_INDEX_DIR, 0755);
+    open_cover_pack();
+    init_workers();
+    refresh_cover_index();
+
     /*
     Mix_Init(MIX_INIT_OGG);
     SDL_AudioSpec desired_spec = { .freq = 44100, .format = SDL_AUDIO_F32, .channels = 2 };
@@ -174,64 +897,62 @@ int main(int argc, char *argv[]) {
     }
     */
 
+    wake_event_type = SDL_RegisterEvents(1);
+    init_frame_pacer();
+
     SDL_Event event;
-    int running = 1;
+    int running = !bench_mode;
+    int prescan_started = 0;
+    int exit_code = bench_mode ? run_bench() : 0;
 
     while (running) {
-        while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_EVENT_QUIT) running = 0;
-
-            if (event.type == SDL_EVENT_JOYSTICK_ADDED) {
-                SDL_Log("Joystick found.");
-                SDL_OpenJoystick(event.jdevice.which);
-            }
+        if (SDL_WaitEventTimeout(&event, next_wait_timeout())) {
+            Uint64 events_start = SDL_GetTicksNS();
+            Uint64 trace_start = trace_begin();
+            do {
+                if (event.type == SDL_EVENT_QUIT) running = 0;
+
+                if (event.type == SDL_EVENT_JOYSTICK_ADDED) {
+                    SDL_Log("Joystick found.");
+                    SDL_OpenJoystick(event.jdevice.which);
+                }
 
-            if (event.type == SDL_EVENT_JOYSTICK_REMOVED) {
-                SDL_Log("Joystick removed.");
-                SDL_CloseJoystick(SDL_GetJoystickFromID(event.jdevice.which));
-            }
+                if (event.type == SDL_EVENT_JOYSTICK_REMOVED) {
+                    SDL_Log("Joystick removed.");
+                    SDL_CloseJoystick(SDL_GetJoystickFromID(event.jdevice.which));
+                }
 
-            handle_events(&event);
-            handle_joystick_input(&event);
+                handle_events(&event);
+                handle_joystick_input(&event);
+            } while (SDL_PollEvent(&event));
+            trace_end("event_pump", trace_start);
+            pending_event_ns += SDL_GetTicksNS() - events_start;
         }
 
-        int win_w, win_h;
-        SDL_GetWindowSize(window, &win_w, &win_h);
-
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-        SDL_RenderClear(renderer);
-
-        if (background_texture) {
-            SDL_FRect dst = { 0, 0, (float)win_w, (float)win_h };
-            SDL_RenderTexture(renderer, background_texture, NULL, &dst);
-        }
+        if (!running || !take_redraw()) continue;
+        render_frame();
 
-        if (logo_texture) {
-            SDL_FRect dst = { (win_w - 200) / 2.0f, 40.0f, 200.0f, 100.0f };
-            SDL_RenderTexture(renderer, logo_texture, NULL, &dst);
+        // Queued only once the first frame is on screen, so startup does not wait on any disk
+        if (!prescan_started) {
+            prescan_started = 1;
+            start_system_prescan();
         }
-
-        if (in_rom_menu)
-            draw_rom_menu();
-        else
-            draw_system_menu();
-
-        SDL_Color sig_color = { 150, 150, 150, 255 };
-        render_text("by MARCO AURELIO SIMAO", 10, win_h - FONT_SIZE - 10, sig_color);
-
-        SDL_RenderPresent(renderer);
-        SDL_Delay(16);
     }
 
+    log_frame_stats();
+
     free_rom_list();
+    if (static_layer) SDL_DestroyTexture(static_layer);
+    free_label_cache();
+    free_glyph_atlas();
+    free_batch();
     TTF_CloseFont(font);
     SDL_DestroyTexture(logo_texture);
     SDL_DestroyTexture(background_texture);
-
-    if (cover_texture) {
-        SDL_DestroyTexture(cover_texture);
-        cover_texture = NULL;
-    }
+    SDL_SetAtomicInt(&prescan_quit, 1);
+    shutdown_workers();
+    free_cover_cache();
+    close_cover_pack();
 
     Mix_FreeMusic(music);
     Mix_CloseAudio();
@@ -239,29 +960,307 @@ int main(int argc, char *argv[]) {
     TTF_Quit();
     SDL_Quit();
 
-    return 0;
+    return exit_code;
 }
 
-static void render_text_centered(const char *text, float y, SDL_Color color) {
-    SDL_Surface *surface = TTF_RenderText_Blended(font, text, SDL_strlen(text), color);
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
-    int text_w = surface->w, text_h = surface->h;
+static void render_frame(void) {
+    Uint64 trace_start = trace_begin();
+    begin_frame();
+    pump_cover_index();
+    pump_cover_uploads();
+    pump_rom_scan();
+
+    int win_w, win_h;
+    SDL_GetWindowSize(window, &win_w, &win_h);
+
+    if (static_layer_dirty) rebuild_static_layer(win_w, win_h);
+
+    if (static_layer) {
+        SDL_FRect dst = { 0, 0, (float)win_w, (float)win_h };
+        SDL_Color white = { 255, 255, 255, 255 };
+        batch_quad(static_layer, NULL, &dst, white);
+    } else {
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderClear(renderer);
+        draw_static_layers(win_w, win_h);
+    }
+
+    if (in_rom_menu && rom_view_grid)
+        draw_rom_grid();
+    else if (in_rom_menu)
+        draw_rom_menu();
+    else
+        draw_system_menu();
+
+    if (hud_visible) draw_hud();
+    cancel_stale_covers();
+
+    batch_flush();
+    Uint64 present_start = SDL_GetTicksNS();
+    SDL_RenderPresent(renderer);
+    Uint64 present_end = SDL_GetTicksNS();
+    trace_end("present", present_start);
+    trace_end("frame", trace_start);
+    record_frame_phases(present_start - frame_start_ns, present_end - present_start);
+    count_rendered_frame();
+    end_frame();
+}
+
+static int init_glyph_atlas(void) {
+    if (!font) return 0;
+
+    glyph_atlas = create_texture(SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, GLYPH_ATLAS_SIZE, GLYPH_ATLAS_SIZE);
+    if (!glyph_atlas) {
+        SDL_Log("Failed to create glyph atlas: %s", SDL_GetError());
+        return 0;
+    }
+
+    // Static textures start undefined, so clear the whole atlas once
+    Uint32 *blank = SDL_calloc(GLYPH_ATLAS_SIZE * GLYPH_ATLAS_SIZE, sizeof(Uint32));
+    if (blank) {
+        SDL_UpdateTexture(glyph_atlas, NULL, blank, GLYPH_ATLAS_SIZE * sizeof(Uint32));
+        SDL_free(blank);
+    }
+
+    SDL_SetTextureBlendMode(glyph_atlas, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(glyph_atlas, SDL_SCALEMODE_NEAREST);
+
+    SDL_memset(glyph_cache, 0, sizeof(glyph_cache));
+    atlas_pen_x = atlas_pen_y = atlas_row_h = 0;
+    atlas_full = 0;
+
+    // Warm up printable ASCII, everything else is added the first time it is drawn
+    for (Uint32 ch = 32; ch < 127; ++ch) get_glyph(ch);
+    return 1;
+}
+
+static void free_glyph_atlas(void) {
+    if (glyph_atlas) {
+        SDL_DestroyTexture(glyph_atlas);
+        glyph_atlas = NULL;
+    }
+    SDL_memset(glyph_cache, 0, sizeof(glyph_cache));
+}
+
+static const Glyph *get_glyph(Uint32 ch) {
+    if (!glyph_atlas || ch == 0) return NULL;
+
+    Uint32 slot = (ch * 2654435761u) & (GLYPH_CACHE_SLOTS - 1);
+    for (int probe = 0; probe < GLYPH_CACHE_SLOTS; ++probe) {
+        Glyph *g = &glyph_cache[slot];
+        if (g->codepoint == ch) return g;
+        if (g->codepoint == 0) break;
+        slot = (slot + 1) & (GLYPH_CACHE_SLOTS - 1);
+    }
+
+    if (glyph_cache[slot].codepoint != 0 || atlas_full) return NULL;
+
+    int minx, maxx, miny, maxy, advance;
+    if (!TTF_GetGlyphMetrics(font, ch, &minx, &maxx, &miny, &maxy, &advance)) return NULL;
+
+    SDL_Color white = { 255, 255, 255, 255 };
+    SDL_Surface *surface = TTF_RenderGlyph_Blended(font, ch, white);
+    if (!surface) return NULL;
+
+    if (surface->format != SDL_PIXELFORMAT_ARGB8888) {
+        SDL_Surface *converted = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_ARGB8888);
+        SDL_DestroySurface(surface);
+        if (!converted) return NULL;
+        surface = converted;
+    }
+
+    if (atlas_pen_x + surface->w + GLYPH_PADDING > GLYPH_ATLAS_SIZE) {
+        atlas_pen_x = 0;
+        atlas_pen_y += atlas_row_h + GLYPH_PADDING;
+        atlas_row_h = 0;
+    }
+    if (atlas_pen_y + surface->h > GLYPH_ATLAS_SIZE || surface->w > GLYPH_ATLAS_SIZE) {
+        SDL_Log("Glyph atlas is full, U+%04X will not be drawn", (unsigned)ch);
+        atlas_full = 1;
+        SDL_DestroySurface(surface);
+        return NULL;
+    }
+
+    SDL_Rect cell = { atlas_pen_x, atlas_pen_y, surface->w, surface->h };
+    SDL_UpdateTexture(glyph_atlas, &cell, surface->pixels, surface->pitch);
+
+    Glyph *g = &glyph_cache[slot];
+    g->codepoint = ch;
+    g->src = (SDL_FRect){ (float)cell.x, (float)cell.y, (float)cell.w, (float)cell.h };
+    g->xoff = minx < 0 ? minx : 0;
+    g->advance = advance;
+
+    atlas_pen_x += surface->w + GLYPH_PADDING;
+    if (surface->h > atlas_row_h) atlas_row_h = surface->h;
+
     SDL_DestroySurface(surface);
+    return g;
+}
+
+static const Glyph *get_glyph_or_fallback(Uint32 ch) {
+    const Glyph *g = get_glyph(ch);
+    return g ? g : get_glyph('?');
+}
+
+static float measure_text(const char *text) {
+    size_t len = SDL_strlen(text);
+    Uint32 prev = 0, ch;
+    float width = 0.0f;
+
+    while ((ch = SDL_StepUTF8(&text, &len)) != 0) {
+        const Glyph *g = get_glyph_or_fallback(ch);
+        if (!g) continue;
+
+        int kerning = 0;
+        if (prev && TTF_GetGlyphKerning(font, prev, g->codepoint, &kerning)) width += kerning;
+        width += g->advance;
+        prev = g->codepoint;
+    }
+    return width;
+}
+
+static void draw_text_quads(const char *text, float x, float y, SDL_Color color) {
+    if (!glyph_atlas) return;
+
+    size_t len = SDL_strlen(text);
+    Uint32 prev = 0, ch;
+    float pen_x = x;
+
+    while ((ch = SDL_StepUTF8(&text, &len)) != 0) {
+        const Glyph *g = get_glyph_or_fallback(ch);
+        if (!g) continue;
+
+        int kerning = 0;
+        if (prev && TTF_GetGlyphKerning(font, prev, g->codepoint, &kerning)) pen_x += kerning;
+        prev = g->codepoint;
+
+        SDL_FRect dst = { pen_x + g->xoff, y, g->src.w, g->src.h };
+        batch_quad(glyph_atlas, &g->src, &dst, color);
+        pen_x += g->advance;
+    }
+}
+
+static int init_label_cache(void) {
+    if (!font) return 0;
+
+    label_slot_h = TTF_GetFontHeight(font);
+    label_texture = create_texture(SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, LABEL_SLOT_W, LABEL_CACHE_SLOTS * label_slot_h);
+    if (!label_texture) {
+        SDL_Log("Label cache disabled: %s", SDL_GetError());
+        return 0;
+    }
+
+    SDL_SetTextureBlendMode(label_texture, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(label_texture, SDL_SCALEMODE_NEAREST);
+    clear_label_cache();
+    return 1;
+}
+
+static void clear_label_cache(void) {
+    SDL_memset(label_cache, 0, sizeof(label_cache));
+}
+
+static void free_label_cache(void) {
+    SDL_Log("Label cache: %llu hits, %llu misses, %llu evictions",
+            (unsigned long long)label_hits, (unsigned long long)label_misses, (unsigned long long)label_evictions);
+
+    if (label_texture) {
+        SDL_DestroyTexture(label_texture);
+        label_texture = NULL;
+    }
+    clear_label_cache();
+}
+
+static const LabelEntry *get_label(const char *text, SDL_Color color) {
+    if (!label_texture || SDL_strlen(text) >= LABEL_TEXT_MAX) return NULL;
+
+    Uint32 hash = SDL_murmur3_32(text, SDL_strlen(text), FONT_SIZE);
+    LabelEntry *victim = &label_cache[0];
+
+    for (int i = 0; i < LABEL_CACHE_SLOTS; ++i) {
+        LabelEntry *e = &label_cache[i];
+        if (e->in_use && e->hash == hash && e->font_size == FONT_SIZE &&
+            e->color.r == color.r && e->color.g == color.g && e->color.b == color.b && e->color.a == color.a &&
+            SDL_strcmp(e->text, text) == 0) {
+            e->last_used = ++label_clock;
+            label_hits++;
+            return e;
+        }
+
+        // Prefer a free slot, otherwise the least recently used one
+        if (victim->in_use && (!e->in_use || e->last_used < victim->last_used)) victim = e;
+    }
+
+    // Composing is deferred when the frame is out of time, the caller draws straight from the glyph atlas
+    if (frame_start_ns && frame_budget_ns() <= 0) return NULL;
+
+    // A label wider than a slot would be cut off, so it is never cached and always drawn from the atlas
+    int text_w = (int)SDL_ceilf(measure_text(text));
+    if (text_w > LABEL_SLOT_W) return NULL;
+
+    label_misses++;
+    if (victim->in_use) label_evictions++;
+
+    int slot = (int)(victim - label_cache);
+    SDL_FRect cell = { 0.0f, (float)(slot * label_slot_h), (float)LABEL_SLOT_W, (float)label_slot_h };
+
+    // Compose the label from the glyph atlas; the slot is cleared to the label color at zero alpha
+    // so blended glyph edges keep their color instead of darkening towards black.
+    // Pending quads belong to the current target and go out before switching.
+    batch_flush();
+    SDL_Texture *prev_target = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, label_texture);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 0);
+    SDL_RenderFillRect(renderer, &cell);
+    draw_text_quads(text, 0.0f, cell.y, color);
+    batch_flush();
+    SDL_SetRenderTarget(renderer, prev_target);
+
+    SDL_strlcpy(victim->text, text, sizeof(victim->text));
+    victim->hash = hash;
+    victim->color = color;
+    victim->font_size = FONT_SIZE;
+    victim->w = text_w;
+    victim->in_use = 1;
+    victim->last_used = ++label_clock;
+    return victim;
+}
+
+static void draw_label(const LabelEntry *label, float x, float y, SDL_Color tint) {
+    int slot = (int)(label - label_cache);
+    SDL_FRect src = { 0.0f, (float)(slot * label_slot_h), (float)label->w, (float)label_slot_h };
+    SDL_FRect dst = { x, y, (float)label->w, (float)label_slot_h };
+    batch_quad(label_texture, &src, &dst, tint);
+}
+
+// Menu rows are cached once in white and tinted through the vertex color, so selecting a row never composes a second variant
+static void render_text_centered(const char *text, float y, SDL_Color color) {
+    Uint64 trace_start = trace_begin();
     int win_w;
     SDL_GetWindowSize(window, &win_w, NULL);
-    SDL_FRect dst = { (win_w - text_w) / 2.0f, y, (float)text_w, (float)text_h };
-    SDL_RenderTexture(renderer, texture, NULL, &dst);
-    SDL_DestroyTexture(texture);
+
+    SDL_Color white = { 255, 255, 255, 255 };
+    const LabelEntry *label = get_label(text, white);
+    if (label) {
+        draw_label(label, SDL_floorf((win_w - label->w) / 2.0f), y, color);
+    } else {
+        float text_w = measure_text(text);
+        draw_text_quads(text, SDL_floorf((win_w - text_w) / 2.0f), y, color);
+    }
+    trace_end("render_text_centered", trace_start);
 }
 
 static void render_text(const char *text, float x, float y, SDL_Color color) {
-    SDL_Surface *surface = TTF_RenderText_Blended(font, text, SDL_strlen(text), color);
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
-    int text_w = surface->w, text_h = surface->h;
-    SDL_DestroySurface(surface);
-    SDL_FRect dst = { x, y, (float)text_w, (float)text_h };
-    SDL_RenderTexture(renderer, texture, NULL, &dst);
-    SDL_DestroyTexture(texture);
+    Uint64 trace_start = trace_begin();
+    SDL_Color white = { 255, 255, 255, 255 };
+    const LabelEntry *label = get_label(text, color);
+    if (label) {
+        draw_label(label, x, y, white);
+    } else {
+        draw_text_quads(text, x, y, color);
+    }
+    trace_end("render_text", trace_start);
 }
 
 static void draw_scrollbar(int item_count, int visible_lines, int scroll_offset, int start_y, int line_height, int win_w) {
@@ -272,10 +1271,90 @@ static void draw_scrollbar(int item_count, int visible_lines, int scroll_offset,
     float handle_y = start_y + (scroll_offset / (float)item_count) * scrollbar_height;
     SDL_FRect bar = { win_w - 20.0f, (float)start_y, 8.0f, scrollbar_height };
     SDL_FRect handle = { win_w - 20.0f, handle_y, 8.0f, handle_height };
-    SDL_SetRenderDrawColor(renderer, 80, 80, 80, 200);
-    SDL_RenderFillRect(renderer, &bar);
-    SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
-    SDL_RenderFillRect(renderer, &handle);
+    SDL_Color bar_color = { 80, 80, 80, 200 };
+    SDL_Color handle_color = { 200, 200, 200, 255 };
+    batch_fill(&bar, bar_color);
+    batch_fill(&handle, handle_color);
+}
+
+static BatchBucket *batch_bucket_for(SDL_Texture *texture) {
+    for (int i = 0; i < batch_bucket_count; ++i) {
+        if (batch_buckets[i].texture == texture) return &batch_buckets[i];
+    }
+
+    if (batch_bucket_count == BATCH_MAX_BUCKETS) batch_flush();
+
+    BatchBucket *b = &batch_buckets[batch_bucket_count++];
+    b->texture = texture;
+    b->tex_w = b->tex_h = 1.0f;
+    if (texture) SDL_GetTextureSize(texture, &b->tex_w, &b->tex_h);
+    b->quad_count = 0;
+    return b;
+}
+
+static void batch_quad(SDL_Texture *texture, const SDL_FRect *src, const SDL_FRect *dst, SDL_Color color) {
+    BatchBucket *b = batch_bucket_for(texture);
+
+    if (b->quad_count == b->quad_capacity) {
+        int capacity = b->quad_capacity ? b->quad_capacity * 2 : 64;
+        SDL_Vertex *verts = SDL_realloc(b->verts, capacity * 4 * sizeof(SDL_Vertex));
+        if (!verts) return;
+        b->verts = verts;
+        int *indices = SDL_realloc(b->indices, capacity * 6 * sizeof(int));
+        if (!indices) return;
+        b->indices = indices;
+        b->quad_capacity = capacity;
+    }
+
+    float u0 = 0.0f, v0 = 0.0f, u1 = 1.0f, v1 = 1.0f;
+    if (texture && src) {
+        u0 = src->x / b->tex_w;
+        v0 = src->y / b->tex_h;
+        u1 = (src->x + src->w) / b->tex_w;
+        v1 = (src->y + src->h) / b->tex_h;
+    }
+
+    SDL_FColor fcolor = { color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f };
+    float x0 = dst->x, y0 = dst->y, x1 = dst->x + dst->w, y1 = dst->y + dst->h;
+
+    int base = b->quad_count * 4;
+    SDL_Vertex *v = &b->verts[base];
+    v[0] = (SDL_Vertex){ { x0, y0 }, fcolor, { u0, v0 } };
+    v[1] = (SDL_Vertex){ { x1, y0 }, fcolor, { u1, v0 } };
+    v[2] = (SDL_Vertex){ { x1, y1 }, fcolor, { u1, v1 } };
+    v[3] = (SDL_Vertex){ { x0, y1 }, fcolor, { u0, v1 } };
+
+    int *idx = &b->indices[b->quad_count * 6];
+    idx[0] = base; idx[1] = base + 1; idx[2] = base + 2;
+    idx[3] = base; idx[4] = base + 2; idx[5] = base + 3;
+
+    b->quad_count++;
+}
+
+static void batch_fill(const SDL_FRect *rect, SDL_Color color) {
+    batch_quad(NULL, NULL, rect, color);
+}
+
+static void batch_flush(void) {
+    for (int i = 0; i < batch_bucket_count; ++i) {
+        BatchBucket *b = &batch_buckets[i];
+        if (b->quad_count) {
+            SDL_RenderGeometry(renderer, b->texture, b->verts, b->quad_count * 4, b->indices, b->quad_count * 6);
+            draw_calls++;
+        }
+        b->quad_count = 0;
+        b->texture = NULL;
+    }
+    batch_bucket_count = 0;
+}
+
+static void free_batch(void) {
+    batch_bucket_count = 0;
+    for (int i = 0; i < BATCH_MAX_BUCKETS; ++i) {
+        SDL_free(batch_buckets[i].verts);
+        SDL_free(batch_buckets[i].indices);
+        SDL_memset(&batch_buckets[i], 0, sizeof(BatchBucket));
+    }
 }
 
 static int has_allowed_extension(const char *filename, const char *allowed_exts) {
@@ -287,115 +1366,1396 @@ static int has_allowed_extension(const char *filename, const char *allowed_exts)
     char temp[64];
     SDL_strlcpy(temp, allowed_exts, sizeof(temp));
 
-    char *token = strtok(temp, ",");
+    // Scans for several systems run on workers at once, so the tokenizer state stays local
+    char *save = NULL;
+    char *token = SDL_strtok_r(temp, ",", &save);
     while (token) {
         if (SDL_strcasecmp(ext, token) == 0) return 1;
-        token = strtok(NULL, ",");
+        token = SDL_strtok_r(NULL, ",", &save);
     }
     return 0;
 }
 
+// Opens the ROM menu with only the Exit entry; the scan job streams the games in ahead of it
 static void load_rom_list(const SystemEntry *sys) {
     free_rom_list();
-    char path[512];
-    snprintf(path, sizeof(path), "./roms/%s/", sys->dir_name);
-    DIR *dir = opendir(path);
-    if (!dir) return;
+    refresh_cover_index();
 
-    int capacity = 20;
-    rom_list = calloc(capacity, sizeof(RomEntry));
-    rom_count = 0;
-    struct dirent *entry;
+    rom_list = calloc(1, sizeof(RomEntry));
+    rom_list[0].display_name = strdup("Exit");
+    rom_list[0].rom_path = NULL;
+    rom_count = 1;
 
+    measure_rom_list();
+    rom_layout_w = 0.0f;
 
-    // 1) Load all files in the main system folder with allowed extensions
-    while ((entry = readdir(dir))) {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+    start_rom_scan(sys);
 
-        char full_path[512];
-        snprintf(full_path, sizeof(full_path), "./roms/%s/%s", sys->dir_name, entry->d_name);
+    // With a current index the scan is done within a frame; waiting that long avoids flashing an empty list
+    Uint64 deadline = SDL_GetTicks() + ROM_SCAN_GRACE_MS;
+    while (rom_scan) {
+        pump_rom_scan();
+        if (!rom_scan || SDL_GetTicks() >= deadline) break;
+        SDL_Delay(1);
+    }
+}
 
-        struct stat st;
-        if (stat(full_path, &st) == -1) continue;
+static void start_rom_scan(const SystemEntry *sys) {
+    RomScan *scan = SDL_calloc(1, sizeof(RomScan));
+    if (!scan) return;
+    scan->mutex = SDL_CreateMutex();
+    if (!scan->mutex) {
+        SDL_free(scan);
+        return;
+    }
+    scan->sys = sys;
+    scan->start_ns = SDL_GetTicksNS();
+    SDL_SetAtomicInt(&scan->refs, 2);
 
-        if (S_ISREG(st.st_mode) && has_allowed_extension(entry->d_name, sys->allowed_exts)) {
-            if (rom_count >= capacity) {
-                capacity *= 2;
-                rom_list = realloc(rom_list, capacity * sizeof(RomEntry));
-            }
-            rom_list[rom_count].display_name = strdup(entry->d_name);  // show file name
-            rom_list[rom_count].rom_path = strdup(full_path);
-            rom_count++;
-        }
+    rom_scan = scan;
+    SDL_AddAtomicInt(&system_scans_active[sys - systems], 1);
+    submit_job(scan_rom_job, discard_rom_scan_job, scan);
+}
+
+// Worker side: the cached index is validated and the changed folders read, streaming entries as they are found
+static void scan_rom_job(void *userdata) {
+    RomScan *scan = userdata;
+    Uint64 trace_start = trace_begin();
+
+    refresh_rom_library(scan->sys, emit_rom_batch, scan);
+    trace_end("scan_rom_library", trace_start);
+    discard_rom_scan_job(scan);
+}
+
+// Also runs for a job dropped at shutdown: marks the scan finished and gives up the job's reference
+static void discard_rom_scan_job(void *userdata) {
+    RomScan *scan = userdata;
+    SDL_LockMutex(scan->mutex);
+    scan->finished = 1;
+    SDL_UnlockMutex(scan->mutex);
+    SDL_AddAtomicInt(&system_scans_active[scan->sys - systems], -1);
+    wake_main_loop();
+    release_rom_scan(scan);
+}
+
+// One background job per system, so the pre-scan overlaps folders without competing with the menu
+static void start_system_prescan(void) {
+    for (size_t i = 0; i < sizeof(systems) / sizeof(SystemEntry); ++i) {
+        submit_background_job(prescan_system_job, NULL, (void *)&systems[i]);
     }
+}
 
-    rewinddir(dir);
+static void prescan_system_job(void *userdata) {
+    const SystemEntry *sys = userdata;
 
-    // 2) Now go through subdirectories and add their files
-    while ((entry = readdir(dir))) {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+    // The menu is reading this system right now and sets the game count itself
+    if (SDL_GetAtomicInt(&system_scans_active[sys - systems])) return;
 
-        char sub_path[512];
-        snprintf(sub_path, sizeof(sub_path), "./roms/%s/%s", sys->dir_name, entry->d_name);
+    Uint64 trace_start = trace_begin();
 
-        struct stat st;
-        if (stat(sub_path, &st) == -1) continue;
-
-        if (S_ISDIR(st.st_mode)) {
-            DIR *subdir = opendir(sub_path);
-            if (!subdir) continue;
-
-            struct dirent *sub_entry;
-            while ((sub_entry = readdir(subdir))) {
-                if (sub_entry->d_type == DT_REG && has_allowed_extension(sub_entry->d_name, sys->allowed_exts)) {
-                    if (rom_count >= capacity) {
-                        capacity *= 2;
-                        rom_list = realloc(rom_list, capacity * sizeof(RomEntry));
-                    }
-                    rom_list[rom_count].display_name = strdup(sub_entry->d_name);  // show file name only, not subdir
-                    char full_file_path[1024];
-                    snprintf(full_file_path, sizeof(full_file_path), "./roms/%s/%s/%s", sys->dir_name, entry->d_name, sub_entry->d_name);
-                    rom_list[rom_count].rom_path = strdup(full_file_path);
-                    rom_count++;
-                }
-            }
-            closedir(subdir);
-        }
+    int games = refresh_rom_library(sys, prescan_emit, NULL);
+    if (games >= 0) {
+        SDL_SetAtomicInt(&system_game_counts[sys - systems], games + 1);
+        wake_main_loop();
     }
 
-    closedir(dir);
+    trace_end("prescan_system", trace_start);
+}
 
-    // Add "Exit" option
-    rom_list = realloc(rom_list, (rom_count + 1) * sizeof(RomEntry));
-    rom_list[rom_count].display_name = strdup("Exit");
-    rom_list[rom_count].rom_path = NULL;
-    rom_count++;
+// Nothing is streamed during the pre-scan; the callback only lets shutdown stop it early
+static int prescan_emit(void *userdata, const SystemEntry *sys, const RomDir *dir, int first, int count) {
+    return !SDL_GetAtomicInt(&prescan_quit);
 }
 
-static void free_rom_list(void) {
-    for (int i = 0; i < rom_count; ++i) {
-        SDL_free(rom_list[i].display_name);
-        SDL_free(rom_list[i].rom_path);
+// Scan callback: copies dir->files[first..first+count) into a batch for the main thread.
+// Returning 0 stops the scan, which is how backing out of the system cancels it.
+static int emit_rom_batch(void *userdata, const SystemEntry *sys, const RomDir *dir, int first, int count) {
+    RomScan *scan = userdata;
+    if (SDL_GetAtomicInt(&scan->cancelled)) return 0;
+
+    RomBatch *batch = SDL_calloc(1, sizeof(RomBatch));
+    RomEntry *entries = batch ? SDL_calloc(count, sizeof(RomEntry)) : NULL;
+    if (!entries) {
+        SDL_free(batch);
+        return 0;
     }
-    SDL_free(rom_list);
-    rom_list = NULL;
-    rom_count = 0;
-    if (cover_texture) {
-        SDL_DestroyTexture(cover_texture);
-        cover_texture = NULL;
+
+    for (int i = 0; i < count; ++i) {
+        const char *file = dir->files[first + i];
+        char full_path[1024];
+        if (dir->name[0]) snprintf(full_path, sizeof(full_path), "./roms/%s/%s/%s", sys->dir_name, dir->name, file);
+        else snprintf(full_path, sizeof(full_path), "./roms/%s/%s", sys->dir_name, file);
+
+        entries[i].display_name = SDL_strdup(file);  // show file name only, not subdir
+        entries[i].rom_path = SDL_strdup(full_path);
     }
+    batch->entries = entries;
+    batch->count = count;
+
+    SDL_LockMutex(scan->mutex);
+    if (scan->batches_tail) scan->batches_tail->next = batch;
+    else scan->batches = batch;
+    scan->batches_tail = batch;
+    SDL_UnlockMutex(scan->mutex);
+
+    wake_main_loop();
+    return 1;
 }
 
-static void handle_events(const SDL_Event *event)
+static void release_rom_scan(RomScan *scan) {
+    if (SDL_AddAtomicInt(&scan->refs, -1) != 1) return;
+
+    RomBatch *batch = scan->batches;
+    while (batch) {
+        RomBatch *next = batch->next;
+        for (int i = 0; i < batch->count; ++i) {
+            SDL_free(batch->entries[i].display_name);
+            SDL_free(batch->entries[i].rom_path);
+        }
+        SDL_free(batch->entries);
+        SDL_free(batch);
+        batch = next;
+    }
+    SDL_DestroyMutex(scan->mutex);
+    SDL_free(scan);
+}
+
+// Main thread, once per frame before drawing: moves the batches that arrived into rom_list. The job's
+// wake event already made this frame happen, so nothing here asks for another one.
+static void pump_rom_scan(void) {
+    if (!rom_scan) return;
+
+    SDL_LockMutex(rom_scan->mutex);
+    RomBatch *batch = rom_scan->batches;
+    rom_scan->batches = rom_scan->batches_tail = NULL;
+    int finished = rom_scan->finished;
+    SDL_UnlockMutex(rom_scan->mutex);
+
+    while (batch) {
+        RomBatch *next = batch->next;
+        append_rom_entries(batch->entries, batch->count);
+        SDL_free(batch->entries);
+        SDL_free(batch);
+        batch = next;
+    }
+
+    if (finished) {
+        SDL_SetAtomicInt(&system_game_counts[rom_scan->sys - systems], rom_count);  // rom_count - 1 games, plus one
+        profile_add(&prof_load_rom_list, rom_scan->start_ns);
+        trace_end("load_rom_list", rom_scan->start_ns);
+        release_rom_scan(rom_scan);
+        rom_scan = NULL;
+    }
+}
+
+static void cancel_rom_scan(void) {
+    if (!rom_scan) return;
+    SDL_SetAtomicInt(&rom_scan->cancelled, 1);
+    release_rom_scan(rom_scan);
+    rom_scan = NULL;
+}
+
+// Takes over the names. New entries go in front of Exit; the selection stays on Exit only if
+// the user already moved it there, otherwise the first batch selects the first game as before.
+static void append_rom_entries(RomEntry *entries, int count) {
+    RomEntry *grown = realloc(rom_list, (rom_count + count) * sizeof(RomEntry));
+    if (!grown) {
+        for (int i = 0; i < count; ++i) {
+            SDL_free(entries[i].display_name);
+            SDL_free(entries[i].rom_path);
+        }
+        return;
+    }
+    rom_list = grown;
+
+    int exit_index = rom_count - 1;
+    rom_list[exit_index + count] = rom_list[exit_index];
+    for (int i = 0; i < count; ++i) {
+        RomEntry *e = &rom_list[exit_index + i];
+        *e = entries[i];
+        e->text_w = measure_text(e->display_name);
+        e->fit_len = rom_layout_w > 0.0f && e->text_w > rom_layout_w ? fit_text(e->display_name, rom_layout_w) : -1;
+    }
+
+    if (selected_rom_index == exit_index && exit_index > 0) selected_rom_index += count;
+    rom_count += count;
+}
+
+// Changes with every batch, so it is drawn from the glyph atlas rather than the label cache
+static void draw_scan_indicator(int win_w, int win_h) {
+    char text[64];
+    SDL_snprintf(text, sizeof(text), "Scanning... %d found", rom_count - 1);
+    SDL_Color color = { 150, 150, 150, 255 };
+    float text_w = measure_text(text);
+    draw_text_quads(text, SDL_floorf(win_w - text_w - 10), (float)(win_h - FONT_SIZE - 10), color);
+}
+
+static RomDir *add_rom_dir(RomLibrary *lib, const char *name, Sint64 mtime) {
+    if (lib->dir_count == lib->dir_capacity) {
+        int capacity = lib->dir_capacity ? lib->dir_capacity * 2 : 16;
+        RomDir *grown = SDL_realloc(lib->dirs, capacity * sizeof(RomDir));
+        if (!grown) return NULL;
+        lib->dirs = grown;
+        lib->dir_capacity = capacity;
+    }
+
+    RomDir *dir = &lib->dirs[lib->dir_count];
+    SDL_memset(dir, 0, sizeof(RomDir));
+    dir->name = SDL_strdup(name);
+    if (!dir->name) return NULL;
+    dir->mtime = mtime;
+    lib->dir_count++;
+    return dir;
+}
+
+static int add_rom_file(RomDir *dir, const char *name) {
+    if (dir->file_count == dir->file_capacity) {
+        int capacity = dir->file_capacity ? dir->file_capacity * 2 : 32;
+        char **grown = SDL_realloc(dir->files, capacity * sizeof(char *));
+        if (!grown) return 0;
+        dir->files = grown;
+        dir->file_capacity = capacity;
+    }
+
+    char *copy = SDL_strdup(name);
+    if (!copy) return 0;
+    dir->files[dir->file_count++] = copy;
+    return 1;
+}
+
+// Moves a folder's entries from one library into another without copying the names
+static void take_rom_dir(RomLibrary *lib, RomDir *src) {
+    if (lib->dir_count == lib->dir_capacity) {
+        int capacity = lib->dir_capacity ? lib->dir_capacity * 2 : 16;
+        RomDir *grown = SDL_realloc(lib->dirs, capacity * sizeof(RomDir));
+        if (!grown) return;
+        lib->dirs = grown;
+        lib->dir_capacity = capacity;
+    }
+
+    lib->dirs[lib->dir_count++] = *src;
+    SDL_memset(src, 0, sizeof(RomDir));
+}
+
+// readdir() returns folders in a stable order, so the search starts right after the previous match
+static RomDir *find_rom_dir(RomLibrary *lib, const char *name, int *hint) {
+    for (int n = 0; n < lib->dir_count; ++n) {
+        int i = (*hint + n) % lib->dir_count;
+        RomDir *dir = &lib->dirs[i];
+        if (dir->name && dir->name[0] && strcmp(dir->name, name) == 0) {
+            *hint = i + 1;
+            return dir;
+        }
+    }
+    return NULL;
+}
+
+static void free_rom_library(RomLibrary *lib) {
+    for (int d = 0; d < lib->dir_count; ++d) {
+        RomDir *dir = &lib->dirs[d];
+        for (int f = 0; f < dir->file_count; ++f) SDL_free(dir->files[f]);
+        SDL_free(dir->files);
+        SDL_free(dir->name);
+    }
+    SDL_free(lib->dirs);
+    SDL_memset(lib, 0, sizeof(RomLibrary));
+}
+
+// Reports dir->files[first..] to the emit callback in ROM_SCAN_BATCH sized pieces; 0 when it asked to stop
+static int emit_rom_files(const SystemEntry *sys, const RomDir *dir, int first, RomEmitFn emit, void *userdata) {
+    if (!emit) return 1;
+    while (first < dir->file_count) {
+        int count = SDL_min(dir->file_count - first, ROM_SCAN_BATCH);
+        if (!emit(userdata, sys, dir, first, count)) return 0;
+        first += count;
+    }
+    return 1;
+}
+
+// Reads a folder in one readdir pass, copying the names out so the entries can then be handled in
+// inode order, which keeps the metadata reads that follow mostly sequential on disk
+static int read_scan_entries(DIR *dir, ScanEntry **entries, int *count, ScanIo *io) {
+    int capacity = 0;
+    *entries = NULL;
+    *count = 0;
+
+    // getdents: counted once per folder, libc issues more only for folders larger than its buffer
+    io->syscalls++;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+
+        if (*count == capacity) {
+            int new_capacity = capacity ? capacity * 2 : 64;
+            ScanEntry *grown = SDL_realloc(*entries, new_capacity * sizeof(ScanEntry));
+            if (!grown) return 0;
+            *entries = grown;
+            capacity = new_capacity;
+        }
+
+        ScanEntry *e = &(*entries)[*count];
+        e->name = SDL_strdup(entry->d_name);
+        if (!e->name) return 0;
+        e->ino = (Uint64)entry->d_ino;
+        e->type = entry->d_type;
+        e->mtime = 0;
+        (*count)++;
+    }
+
+    if (*count) SDL_qsort(*entries, *count, sizeof(ScanEntry), compare_scan_inodes);
+    return 1;
+}
+
+static int SDLCALL compare_scan_inodes(const void *a, const void *b) {
+    const ScanEntry *ea = a, *eb = b;
+    return ea->ino < eb->ino ? -1 : ea->ino > eb->ino;
+}
+
+static void free_scan_entries(ScanEntry *entries, int count) {
+    for (int i = 0; i < count; ++i) SDL_free(entries[i].name);
+    SDL_free(entries);
+}
+
+static int needs_scan_stat(const ScanEntry *e, const char *allowed_exts, int want_dirs) {
+    if (e->type == DT_DIR ? !want_dirs : e->type != DT_UNKNOWN && e->type != DT_LNK) return 0;
+    return want_dirs || has_allowed_extension(e->name, allowed_exts);
+}
+
+static Sint64 stat_mtime_ns(const struct stat *st) {
+#ifdef __APPLE__
+    return (Sint64)st->st_mtimespec.tv_sec * SDL_NS_PER_SECOND + st->st_mtimespec.tv_nsec;
+#else
+    return (Sint64)st->st_mtim.tv_sec * SDL_NS_PER_SECOND + st->st_mtim.tv_nsec;
+#endif
+}
+
+static void stat_scan_entry(ScanIo *io, int dir_fd, ScanEntry *e) {
+    struct stat st;
+    io->syscalls++;
+    if (fstatat(dir_fd, e->name, &st, 0) == -1) {
+        e->type = DT_UNKNOWN;
+        return;
+    }
+    e->type = S_ISREG(st.st_mode) ? DT_REG : S_ISDIR(st.st_mode) ? DT_DIR : DT_UNKNOWN;
+    e->mtime = stat_mtime_ns(&st);
+}
+
+#ifdef HAVE_LIBURING
+static void open_scan_ring(ScanIo *io) {
+    io->ring_open = io->ring_ready = io->ring_stuck = 0;
+    io->statx_bufs = SDL_malloc(SCAN_URING_DEPTH * sizeof(struct statx));
+    if (!io->statx_bufs) return;
+
+    io->syscalls++;
+    if (io_uring_queue_init(SCAN_URING_DEPTH, &io->ring, 0) < 0) {
+        SDL_free(io->statx_bufs);
+        io->statx_bufs = NULL;
+        return;
+    }
+    io->ring_open = 1;
+
+    // statx and openat need Linux 5.6; anything older keeps the synchronous path
+    struct io_uring_probe *probe = io_uring_get_probe_ring(&io->ring);
+    io->syscalls++;
+    if (probe && io_uring_opcode_supported(probe, IORING_OP_STATX) && io_uring_opcode_supported(probe, IORING_OP_OPENAT)) {
+        io->ring_ready = 1;
+    } else {
+        close_scan_ring(io);
+    }
+    if (probe) io_uring_free_probe(probe);
+}
+
+// Also tears down a ring that failed during the scan. Buffers of requests that never completed are
+// left allocated, since the kernel may still write into them after the ring is gone.
+static void close_scan_ring(ScanIo *io) {
+    if (!io->ring_open) return;
+    io_uring_queue_exit(&io->ring);
+    io->syscalls++;
+    io->ring_open = io->ring_ready = 0;
+
+    if (io->ring_stuck) SDL_Log("io_uring requests did not complete, leaving their buffers allocated");
+    else SDL_free(io->statx_bufs);
+    io->statx_bufs = NULL;
+}
+
+// Submits whatever was queued and waits for at least one completion. On failure the ring is given
+// up for the rest of the scan: callers collect what the kernel already has with wait_scan_ring()
+// and finish the rest synchronously.
+static int submit_scan_ring(ScanIo *io) {
+    for (;;) {
+        io->syscalls++;
+        int ret = io_uring_submit_and_wait(&io->ring, 1);
+        if (ret >= 0) return 1;
+        if (ret != -EINTR) break;
+    }
+    SDL_Log("io_uring submit failed, scanning synchronously");
+    io->ring_ready = 0;
+    return 0;
+}
+
+// Next completion of a ring that was given up, or NULL when none arrives within a second;
+// requests left then are marked stuck so their buffers outlive the ring
+static struct io_uring_cqe *wait_scan_ring(ScanIo *io) {
+    struct __kernel_timespec timeout = { 1, 0 };
+    struct io_uring_cqe *cqe;
+    for (;;) {
+        io->syscalls++;
+        int ret = io_uring_wait_cqe_timeout(&io->ring, &cqe, &timeout);
+        if (ret == 0) return cqe;
+        if (ret != -EINTR) break;
+    }
+    io->ring_stuck = 1;
+    return NULL;
+}
+
+// Next completion to handle: whatever is ready while the ring works, the stragglers once it failed
+static struct io_uring_cqe *next_scan_completion(ScanIo *io) {
+    struct io_uring_cqe *cqe;
+    if (!io->ring_ready) return wait_scan_ring(io);
+    return io_uring_peek_cqe(&io->ring, &cqe) == 0 ? cqe : NULL;
+}
+
+// Keeps up to SCAN_URING_DEPTH statx requests in flight, refilling the queue as completions arrive,
+// so a high-latency mount pays roughly one round trip per batch instead of one per entry
+static void resolve_scan_entries_ring(ScanIo *io, int dir_fd, ScanEntry *entries, int count,
+                                      const char *allowed_exts, int want_dirs) {
+    int slot_entry[SCAN_URING_DEPTH];   // entry being resolved in each statx buffer, -1 when free
+    int free_slots[SCAN_URING_DEPTH];
+    int queued_slots[SCAN_URING_DEPTH]; // prepared but not yet taken by the kernel, oldest first
+    int free_count = SCAN_URING_DEPTH, inflight = 0, queued = 0, next = 0;
+    for (int s = 0; s < SCAN_URING_DEPTH; ++s) {
+        slot_entry[s] = -1;
+        free_slots[s] = s;
+    }
+
+    while (next < count || inflight) {
+        while (free_count && next < count) {
+            ScanEntry *e = &entries[next];
+            if (!needs_scan_stat(e, allowed_exts, want_dirs)) {
+                next++;
+                continue;
+            }
+            struct io_uring_sqe *sqe = io_uring_get_sqe(&io->ring);
+            if (!sqe) break;
+            int slot = free_slots[--free_count];
+            slot_entry[slot] = next++;
+            io_uring_prep_statx(sqe, dir_fd, e->name, 0, STATX_TYPE | STATX_MTIME, &io->statx_bufs[slot]);
+            io_uring_sqe_set_data64(sqe, (Uint64)slot);
+            queued_slots[queued++] = slot;
+            inflight++;
+        }
+        if (!inflight) break;
+
+        // The kernel takes SQEs in order, so whatever it left are the newest ones. After a failed
+        // submit they will never complete: they are resolved here instead of being waited for.
+        int submitted = submit_scan_ring(io);
+        int left = SDL_min((int)io_uring_sq_ready(&io->ring), queued);
+        for (int q = 0; q < left; ++q) {
+            int slot = queued_slots[queued - left + q];
+            if (submitted) {
+                queued_slots[q] = slot;
+                continue;
+            }
+            stat_scan_entry(io, dir_fd, &entries[slot_entry[slot]]);
+            slot_entry[slot] = -1;
+            inflight--;
+        }
+        queued = submitted ? left : 0;
+
+        struct io_uring_cqe *cqe;
+        while (inflight && (cqe = next_scan_completion(io))) {
+            int slot = (int)io_uring_cqe_get_data64(cqe);
+            if (slot_entry[slot] < 0) {
+                // A request resolved above after all; its result is no longer needed
+                io_uring_cqe_seen(&io->ring, cqe);
+                continue;
+            }
+            ScanEntry *e = &entries[slot_entry[slot]];
+            const struct statx *stx = &io->statx_bufs[slot];
+            if (cqe->res < 0) {
+                e->type = DT_UNKNOWN;
+            } else {
+                e->type = S_ISREG(stx->stx_mode) ? DT_REG : S_ISDIR(stx->stx_mode) ? DT_DIR : DT_UNKNOWN;
+                e->mtime = (Sint64)stx->stx_mtime.tv_sec * SDL_NS_PER_SECOND + stx->stx_mtime.tv_nsec;
+            }
+            io_uring_cqe_seen(&io->ring, cqe);
+            slot_entry[slot] = -1;
+            free_slots[free_count++] = slot;
+            inflight--;
+        }
+
+        if (!io->ring_ready) {
+            // Entries whose request never completed, and those not queued yet, are resolved synchronously
+            for (int s = 0; s < SCAN_URING_DEPTH; ++s) {
+                if (slot_entry[s] >= 0) stat_scan_entry(io, dir_fd, &entries[slot_entry[s]]);
+            }
+            for (; next < count; ++next) {
+                if (needs_scan_stat(&entries[next], allowed_exts, want_dirs)) stat_scan_entry(io, dir_fd, &entries[next]);
+            }
+            return;
+        }
+    }
+}
+#endif
+
+// Metadata only where d_type does not already answer the question: DT_UNKNOWN (XFS, NFS and some
+// FUSE mounts), symlinks, and folders when their mtime is wanted. Without want_dirs only names with
+// an allowed extension are worth resolving.
+static void resolve_scan_entries(ScanIo *io, int dir_fd, ScanEntry *entries, int count, const char *allowed_exts,
+                                 int want_dirs) {
+#ifdef HAVE_LIBURING
+    if (io->ring_ready) {
+        resolve_scan_entries_ring(io, dir_fd, entries, count, allowed_exts, want_dirs);
+        return;
+    }
+#endif
+    for (int i = 0; i < count; ++i) {
+        if (needs_scan_stat(&entries[i], allowed_exts, want_dirs)) stat_scan_entry(io, dir_fd, &entries[i]);
+    }
+}
+
+// Opens a window of pending subfolders at once, so their opens overlap on slow mounts. fds[] comes
+// in as -2 and goes out as the fd, or -1 for folders that could not be opened.
+static void open_scan_dirs(ScanIo *io, int parent_fd, RomDir **dirs, int *fds, int count) {
+#ifdef HAVE_LIBURING
+    if (io->ring_ready) {
+        int queued = 0;
+        for (; queued < count; ++queued) {
+            struct io_uring_sqe *sqe = io_uring_get_sqe(&io->ring);
+            if (!sqe) break;
+            io_uring_prep_openat(sqe, parent_fd, dirs[queued]->name, O_RDONLY | O_DIRECTORY, 0);
+            io_uring_sqe_set_data64(sqe, (Uint64)queued);
+        }
+
+        // Opens that completed are kept even when the ring fails, so no folder is opened twice. The
+        // ones a failed submit left in the queue never complete and are opened synchronously below.
+        int done = 0, expected = queued;
+        while (done < expected) {
+            if (io->ring_ready && !submit_scan_ring(io)) expected -= SDL_min((int)io_uring_sq_ready(&io->ring), expected - done);
+            struct io_uring_cqe *cqe;
+            while (done < expected && (cqe = next_scan_completion(io))) {
+                fds[io_uring_cqe_get_data64(cqe)] = cqe->res < 0 ? -1 : cqe->res;
+                io_uring_cqe_seen(&io->ring, cqe);
+                done++;
+            }
+            if (!io->ring_ready) break;
+        }
+    }
+#endif
+    for (int i = 0; i < count; ++i) {
+        if (fds[i] != -2) continue;
+        io->syscalls++;
+        fds[i] = openat(parent_fd, dirs[i]->name, O_RDONLY | O_DIRECTORY);
+    }
+}
+
+// Reads one subfolder from an fd opened relative to its parent, so no path is built or resolved again
+static int scan_rom_subdir(const SystemEntry *sys, int fd, RomDir *dir, ScanIo *io, RomEmitFn emit, void *userdata) {
+    if (fd == -1) return 1;
+
+    DIR *subdir = fdopendir(fd);
+    if (!subdir) {
+        io->syscalls++;
+        close(fd);
+        return 1;
+    }
+
+    ScanEntry *entries;
+    int count;
+    read_scan_entries(subdir, &entries, &count, io);
+    resolve_scan_entries(io, dirfd(subdir), entries, count, sys->allowed_exts, 0);
+
+    for (int i = 0; i < count; ++i) {
+        if (entries[i].type == DT_REG && has_allowed_extension(entries[i].name, sys->allowed_exts)) {
+            add_rom_file(dir, entries[i].name);
+        }
+    }
+    free_scan_entries(entries, count);
+
+    io->syscalls++;
+    closedir(subdir);
+    return emit_rom_files(sys, dir, 0, emit, userdata);
+}
+
+// Emits out's subfolders in list order, reading the pending ones from disk a window at a time.
+// Returns 0 when emit stopped the scan.
+static int scan_rom_subdirs(const SystemEntry *sys, int top_fd, RomLibrary *out, ScanIo *io, RomEmitFn emit, void *userdata) {
+    RomDir *pending[SCAN_OPEN_BATCH];
+    int fds[SCAN_OPEN_BATCH];
+
+    for (int d = 1; d < out->dir_count;) {
+        int end = SDL_min(out->dir_count, d + SCAN_OPEN_BATCH), count = 0;
+        for (int i = d; i < end; ++i) {
+            if (out->dirs[i].pending) {
+                pending[count] = &out->dirs[i];
+                fds[count++] = -2;
+            }
+        }
+        if (count) open_scan_dirs(io, top_fd, pending, fds, count);
+
+        int ok = 1, p = 0;
+        for (; d < end; ++d) {
+            RomDir *sub = &out->dirs[d];
+            if (!sub->pending) {
+                if (ok) ok = emit_rom_files(sys, sub, 0, emit, userdata);
+                continue;
+            }
+            int fd = fds[p++];
+            sub->pending = 0;
+            if (ok) {
+                ok = scan_rom_subdir(sys, fd, sub, io, emit, userdata);
+            } else if (fd >= 0) {
+                io->syscalls++;
+                close(fd);
+            }
+        }
+        if (!ok) return 0;
+    }
+    return 1;
+}
+
+// A folder modified within LIBRARY_RACY_NS of the scan can gain a file without its mtime moving on
+// filesystems with coarse timestamps, so it is recorded as 0 and read again on the next scan
+static Sint64 index_dir_mtime(const ScanIo *io, Sint64 mtime) {
+    return mtime > io->start_ns - LIBRARY_RACY_NS ? 0 : mtime;
+}
+
+// Scans ./roms/<system>, taking over every folder from the cached index whose mtime is unchanged
+// (a folder's mtime moves whenever an entry is added, removed or renamed in it). Entries move out
+// of cached. Folders are reported to emit in list order as they become final, system folder first.
+// Returns 1 when anything had to be read from disk again, 0 when the index was current, and -1 when
+// emit stopped the scan, leaving out incomplete.
+static int scan_rom_library(const SystemEntry *sys, RomLibrary *cached, RomLibrary *out, ScanIo *io, RomEmitFn emit, void *userdata) {
+    char path[512];
+    snprintf(path, sizeof(path), "./roms/%s", sys->dir_name);
+    SDL_memset(out, 0, sizeof(RomLibrary));
+
+    io->syscalls++;
+    int top_fd = open(path, O_RDONLY | O_DIRECTORY);
+    if (top_fd == -1) return cached->dir_count != 0;
+
+    struct stat st;
+    io->syscalls++;
+    if (fstat(top_fd, &st) == -1) {
+        io->syscalls++;
+        close(top_fd);
+        return cached->dir_count != 0;
+    }
+
+    int result = 0;
+    RomDir *cached_top = cached->dir_count && cached->dirs[0].name[0] == '\0' ? &cached->dirs[0] : NULL;
+
+    if (cached_top && cached_top->mtime == stat_mtime_ns(&st)) {
+        // Same listing as last time, so only the subfolders can have changed
+        take_rom_dir(out, cached_top);
+
+        int count = cached->dir_count - 1;
+        ScanEntry *subs = count ? SDL_calloc(count, sizeof(ScanEntry)) : NULL;
+        if (count && !subs) result = -1;
+        for (int i = 0; subs && i < count; ++i) {
+            subs[i].name = cached->dirs[i + 1].name;
+            subs[i].type = DT_DIR;
+        }
+        if (subs) resolve_scan_entries(io, top_fd, subs, count, sys->allowed_exts, 1);
+
+        for (int i = 0; subs && i < count; ++i) {
+            RomDir *sub = &cached->dirs[i + 1];
+            if (subs[i].type != DT_DIR) {
+                result = 1;
+            } else if (subs[i].mtime == sub->mtime) {
+                take_rom_dir(out, sub);
+            } else {
+                RomDir *dir = add_rom_dir(out, sub->name, index_dir_mtime(io, subs[i].mtime));
+                if (dir) dir->pending = 1;
+                result = 1;
+            }
+        }
+        SDL_free(subs);
+
+        if (result < 0 || !emit_rom_files(sys, &out->dirs[0], 0, emit, userdata) ||
+            !scan_rom_subdirs(sys, top_fd, out, io, emit, userdata)) {
+            result = -1;
+        }
+
+        io->syscalls++;
+        close(top_fd);
+        return result;
+    }
+
+    // The listing changed: read the system folder again, keeping subfolders whose mtime did not move.
+    // Subfolders are only listed here and read afterwards, so the system folder's files come first.
+    DIR *dir = fdopendir(top_fd);
+    if (!dir || !add_rom_dir(out, "", index_dir_mtime(io, stat_mtime_ns(&st)))) {
+        io->syscalls++;
+        if (dir) closedir(dir);
+        else close(top_fd);
+        return -1;
+    }
+
+    ScanEntry *entries;
+    int count;
+    read_scan_entries(dir, &entries, &count, io);
+    resolve_scan_entries(io, dirfd(dir), entries, count, sys->allowed_exts, 1);
+
+    int hint = 0;
+    for (int i = 0; i < count; ++i) {
+        ScanEntry *e = &entries[i];
+        if (e->type == DT_REG && has_allowed_extension(e->name, sys->allowed_exts)) {
+            add_rom_file(&out->dirs[0], e->name);
+        } else if (e->type == DT_DIR) {
+            RomDir *old = find_rom_dir(cached, e->name, &hint);
+            if (old && old->mtime == e->mtime) {
+                take_rom_dir(out, old);
+            } else {
+                RomDir *sub = add_rom_dir(out, e->name, index_dir_mtime(io, e->mtime));
+                if (sub) sub->pending = 1;
+            }
+        }
+    }
+    free_scan_entries(entries, count);
+
+    result = emit_rom_files(sys, &out->dirs[0], 0, emit, userdata) &&
+             scan_rom_subdirs(sys, dirfd(dir), out, io, emit, userdata) ? 1 : -1;
+
+    io->syscalls++;
+    closedir(dir);
+    return result;
+}
+
+// Shared by the menu's scan and the pre-scan: validates the cached index, rescans what changed and
+// writes the index back. Returns the game count, or -1 when emit stopped the scan.
+static int refresh_rom_library(const SystemEntry *sys, RomEmitFn emit, void *userdata) {
+    Uint64 start = SDL_GetTicksNS();
+
+    ScanIo io = {0};
+    SDL_Time now;
+    io.start_ns = SDL_GetCurrentTime(&now) ? (Sint64)now : 0;
+#ifdef HAVE_LIBURING
+    open_scan_ring(&io);
+#endif
+
+    RomLibrary cached, library;
+    load_library_index(sys, &cached);
+    int rescanned = scan_rom_library(sys, &cached, &library, &io, emit, userdata);
+    if (rescanned > 0) save_library_index(sys, &library);
+
+    int games = -1;
+    if (rescanned >= 0) {
+        games = 0;
+        for (int d = 0; d < library.dir_count; ++d) games += library.dirs[d].file_count;
+    }
+
+#ifdef HAVE_LIBURING
+    int used_ring = io.ring_open;
+    close_scan_ring(&io);
+#else
+    int used_ring = 0;
+#endif
+
+    Uint32 syscalls = cached.syscalls + io.syscalls;
+    SDL_AddAtomicInt(&scan_syscalls_total, (int)syscalls);
+    if (games >= 0) {
+        SDL_Log("Scanned %s: %d games in %.1f ms, %u syscalls%s%s", sys->dir_name, games,
+                (SDL_GetTicksNS() - start) / (double)SDL_NS_PER_MS, syscalls,
+                used_ring ? " (io_uring)" : "", rescanned ? "" : " (index current)");
+    }
+
+    free_rom_library(&cached);
+    free_rom_library(&library);
+    return games;
+}
+
+// Index file, little-endian: magic, hash of the allowed extensions, folder count, then per folder
+// its mtime in ns, file count and name followed by the file names, each string length-prefixed
+static int read_index_string(SDL_IOStream *io, char *buf, size_t size) {
+    Uint32 len;
+    if (!SDL_ReadU32LE(io, &len) || len >= size) return 0;
+    if (len && SDL_ReadIO(io, buf, len) != len) return 0;
+    buf[len] = '\0';
+    return 1;
+}
+
+static int write_index_string(SDL_IOStream *io, const char *s) {
+    size_t len = SDL_strlen(s);
+    return SDL_WriteU32LE(io, (Uint32)len) && SDL_WriteIO(io, s, len) == len;
+}
+
+static void library_index_path(const SystemEntry *sys, char *path, size_t size) {
+    snprintf(path, size, "%s/%s.idx", LIBRARY_INDEX_DIR, sys->dir_name);
+}
+
+// Maps the system's index and validates it while parsing; anything malformed reads as no index
+static int load_library_index(const SystemEntry *sys, RomLibrary *lib) {
+    SDL_memset(lib, 0, sizeof(RomLibrary));
+
+    char path[512];
+    library_index_path(sys, path, sizeof(path));
+    lib->syscalls = 1;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return 0;
+
+    struct stat st;
+    lib->syscalls += 2;
+    if (fstat(fd, &st) == -1 || st.st_size < 12) {
+        close(fd);
+        return 0;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    lib->syscalls += 2;
+    if (map == MAP_FAILED) return 0;
+
+    SDL_IOStream *io = SDL_IOFromConstMem(map, (size_t)st.st_size);
+    Uint32 magic = 0, exts_hash = 0, dir_count = 0;
+    int ok = io && SDL_ReadU32LE(io, &magic) && SDL_ReadU32LE(io, &exts_hash) && SDL_ReadU32LE(io, &dir_count) &&
+             magic == LIBRARY_MAGIC && exts_hash == SDL_murmur3_32(sys->allowed_exts, SDL_strlen(sys->allowed_exts), 0);
+
+    char name[LIBRARY_MAX_NAME];
+    for (Uint32 d = 0; ok && d < dir_count; ++d) {
+        Sint64 mtime;
+        Uint32 file_count;
+        ok = SDL_ReadS64LE(io, &mtime) && SDL_ReadU32LE(io, &file_count) && read_index_string(io, name, sizeof(name));
+
+        RomDir *dir = ok ? add_rom_dir(lib, name, mtime) : NULL;
+        ok = dir != NULL;
+        for (Uint32 f = 0; ok && f < file_count; ++f) {
+            ok = read_index_string(io, name, sizeof(name)) && add_rom_file(dir, name);
+        }
+    }
+
+    if (io) SDL_CloseIO(io);
+    munmap(map, (size_t)st.st_size);
+
+    Uint32 syscalls = lib->syscalls + 1;
+    if (!ok) free_rom_library(lib);
+    lib->syscalls = syscalls;
+    return ok;
+}
+
+// Written to a temporary name first and renamed, so a crash never leaves a torn index behind
+static void save_library_index(const SystemEntry *sys, const RomLibrary *lib) {
+    char path[512], tmp_path[600];
+    library_index_path(sys, path, sizeof(path));
+    SDL_snprintf(tmp_path, sizeof(tmp_path), "%s.%llu.tmp", path, (unsigned long long)SDL_GetCurrentThreadID());
+
+    SDL_IOStream *io = SDL_IOFromFile(tmp_path, "wb");
+    if (!io) return;
+
+    int ok = SDL_WriteU32LE(io, LIBRARY_MAGIC) &&
+             SDL_WriteU32LE(io, SDL_murmur3_32(sys->allowed_exts, SDL_strlen(sys->allowed_exts), 0)) &&
+             SDL_WriteU32LE(io, (Uint32)lib->dir_count);
+
+    for (int d = 0; ok && d < lib->dir_count; ++d) {
+        const RomDir *dir = &lib->dirs[d];
+        ok = SDL_WriteS64LE(io, dir->mtime) && SDL_WriteU32LE(io, (Uint32)dir->file_count) && write_index_string(io, dir->name);
+        for (int f = 0; ok && f < dir->file_count; ++f) ok = write_index_string(io, dir->files[f]);
+    }
+
+    if (!SDL_CloseIO(io)) ok = 0;
+    if (ok) ok = rename(tmp_path, path) == 0;
+    if (!ok) remove(tmp_path);
+}
+
+// Layout pass: names are measured from the glyph atlas advances once per load,
+// and only the truncation points are recomputed when the row width changes
+static void measure_rom_list(void) {
+    for (int i = 0; i < rom_count; ++i) {
+        rom_list[i].text_w = measure_text(rom_list[i].display_name);
+        rom_list[i].fit_len = -1;
+    }
+}
+
+static void layout_rom_list(float max_w) {
+    for (int i = 0; i < rom_count; ++i) {
+        RomEntry *e = &rom_list[i];
+        e->fit_len = e->text_w > max_w ? fit_text(e->display_name, max_w) : -1;
+    }
+    rom_layout_w = max_w;
+}
+
+// Returns how many bytes of text fit in max_w together with the ellipsis
+static int fit_text(const char *text, float max_w) {
+    float limit = max_w - measure_text(ELLIPSIS);
+    const char *p = text;
+    size_t len = SDL_strlen(text);
+    Uint32 prev = 0, ch;
+    float width = 0.0f;
+    int fit = 0;
+
+    while ((ch = SDL_StepUTF8(&p, &len)) != 0) {
+        const Glyph *g = get_glyph_or_fallback(ch);
+        if (g) {
+            int kerning = 0;
+            if (prev && TTF_GetGlyphKerning(font, prev, g->codepoint, &kerning)) width += kerning;
+            width += g->advance;
+            prev = g->codepoint;
+        }
+        if (width > limit) break;
+        fit = (int)(p - text);
+    }
+
+    while (fit > 0 && text[fit - 1] == ' ') fit--;
+    return fit;
+}
+
+static void free_rom_list(void) {
+    cancel_rom_scan();
+    for (int i = 0; i < rom_count; ++i) {
+        SDL_free(rom_list[i].display_name);
+        SDL_free(rom_list[i].rom_path);
+    }
+    SDL_free(rom_list);
+    rom_list = NULL;
+    rom_count = 0;
+}
+
+static void request_redraw(void) {
+    frame_dirty = 1;
+}
+
+static void request_redraw_at(Uint64 when) {
+    if (!redraw_deadline || when < redraw_deadline) redraw_deadline = when;
+}
+
+// Safe to call from any thread, the event wakes SDL_WaitEventTimeout and invalidates the frame
+static void wake_main_loop(void) {
+    if (!wake_event_type) return;
+    SDL_Event wake;
+    SDL_zero(wake);
+    wake.type = wake_event_type;
+    SDL_PushEvent(&wake);
+}
+
+static Sint32 next_wait_timeout(void) {
+    if (frame_dirty) return 0;
+    if (!redraw_deadline) return -1;
+
+    Uint64 now = SDL_GetTicks();
+    return redraw_deadline > now ? (Sint32)(redraw_deadline - now) : 0;
+}
+
+static int take_redraw(void) {
+    if (redraw_deadline && SDL_GetTicks() >= redraw_deadline) {
+        redraw_deadline = 0;
+        frame_dirty = 1;
+    }
+    if (!frame_dirty) return 0;
+
+    frame_dirty = 0;
+    return 1;
+}
+
+// Every frame period that passed without a redraw counts as a skipped frame
+static void count_rendered_frame(void) {
+    Uint64 now = SDL_GetTicksNS();
+    if (last_frame_ns) {
+        Uint64 intervals = (now - last_frame_ns) / frame_period_ns;
+        if (intervals > 1) frames_skipped += intervals - 1;
+    }
+    last_frame_ns = now;
+    frames_rendered++;
+}
+
+static void log_frame_stats(void) {
+    Uint64 intervals = last_frame_ns ? (SDL_GetTicksNS() - last_frame_ns) / frame_period_ns : 0;
+    if (intervals > 1) frames_skipped += intervals - 1;
+    SDL_Log("Frames: %llu rendered, %llu skipped", (unsigned long long)frames_rendered, (unsigned long long)frames_skipped);
+}
+
+static void init_frame_pacer(void) {
+    const SDL_DisplayMode *mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(window));
+    if (mode && mode->refresh_rate > 0.0f) {
+        frame_period_ns = (Uint64)(SDL_NS_PER_SECOND / mode->refresh_rate);
+    }
+
+    // The benchmark measures raw frame cost, so it neither waits for vsync nor sleeps
+    vsync_enabled = bench_mode ? 0 : SDL_SetRenderVSync(renderer, 1);
+    SDL_Log("Frame pacing: %s, %.2f ms per frame", vsync_enabled ? "vsync" : "timer",
+            frame_period_ns / (double)SDL_NS_PER_MS);
+}
+
+static void begin_frame(void) {
+    frame_start_ns = SDL_GetTicksNS();
+    frame_serial++;
+}
+
+// With vsync the present already waits for the display; otherwise sleep until the next deadline.
+// Deadlines advance by whole periods so the rate does not drift with the frame's own work.
+static void end_frame(void) {
+    if (vsync_enabled || bench_mode) return;
+
+    Uint64 now = SDL_GetTicksNS();
+    if (next_frame_ns < frame_start_ns) next_frame_ns = frame_start_ns;  // first frame after idling
+    next_frame_ns += frame_period_ns;
+    if (next_frame_ns <= now) {
+        next_frame_ns = now;  // missed the deadline, resync instead of bursting to catch up
+        return;
+    }
+    SDL_DelayPrecise(next_frame_ns - now);
+}
+
+// Time left in the current frame for optional work such as texture uploads or text composition.
+// Work that can be deferred should stop once this reaches zero.
+static Sint64 frame_budget_ns(void) {
+    Sint64 deadline = (Sint64)(frame_start_ns + frame_period_ns - PRESENT_RESERVE_NS);
+    return deadline - (Sint64)SDL_GetTicksNS();
+}
+
+static SDL_Texture *create_texture(SDL_PixelFormat format, SDL_TextureAccess access, int w, int h) {
+    SDL_Texture *texture = SDL_CreateTexture(renderer, format, access, w, h);
+    if (texture) textures_created++;
+    return texture;
+}
+
+static SDL_Texture *load_texture(const char *path) {
+    SDL_Texture *texture = IMG_LoadTexture(renderer, path);
+    if (texture) textures_created++;
+    return texture;
+}
+
+// Large JPEGs are decoded straight to about the size they are drawn at; anything else goes through SDL_image
+static SDL_Texture *load_scaled_texture(const char *path, int target_w, int target_h) {
+    SDL_Surface *surface = load_jpeg_scaled(path, target_w, target_h);
+    if (!surface) return load_texture(path);
+
+    SDL_Texture *texture = texture_from_surface(surface);
+    SDL_DestroySurface(surface);
+    return texture;
+}
+
+static SDL_Texture *texture_from_surface(SDL_Surface *surface) {
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (texture) textures_created++;
+    return texture;
+}
+
+static void toggle_hud(void) {
+    hud_visible = !hud_visible;
+    request_redraw();
+}
+
+static void record_frame_phases(Uint64 draw_ns, Uint64 present_ns) {
+    Uint64 total_ns = pending_event_ns + draw_ns + present_ns;
+    int bin = (int)(total_ns / HUD_BIN_NS);
+    if (bin >= HUD_BINS) bin = HUD_BINS - 1;
+
+    // Slide the window: the oldest sample leaves the histogram once the ring is full
+    HudSample *sample = &hud_history[hud_history_pos];
+    if (hud_history_len == HUD_HISTORY) hud_bins[sample->bin]--;
+    else hud_history_len++;
+    sample->start_ns = frame_start_ns;
+    sample->bin = bin;
+    hud_bins[bin]++;
+    hud_history_pos = (hud_history_pos + 1) % HUD_HISTORY;
+
+    hud_event_ns = pending_event_ns;
+    hud_draw_ns = draw_ns;
+    hud_present_ns = present_ns;
+    pending_event_ns = 0;
+
+    hud_textures_per_frame = (int)(textures_created - hud_textures_mark);
+    hud_textures_mark = textures_created;
+    hud_draw_calls_per_frame = (int)(draw_calls - hud_draw_calls_mark);
+    hud_draw_calls_mark = draw_calls;
+
+    if (hud_visible) request_redraw_at(SDL_GetTicks() + HUD_REFRESH_MS);
+}
+
+// Upper edge of the histogram bin holding the p-th percentile, in milliseconds
+static float frame_time_percentile(float p) {
+    if (!hud_history_len) return 0.0f;
+
+    Uint32 rank = (Uint32)SDL_ceilf(p * hud_history_len);
+    if (rank < 1) rank = 1;
+
+    Uint32 seen = 0;
+    for (int i = 0; i < HUD_BINS; ++i) {
+        seen += hud_bins[i];
+        if (seen >= rank) return (i + 1) * HUD_BIN_NS / (float)SDL_NS_PER_MS;
+    }
+    return HUD_BINS * HUD_BIN_NS / (float)SDL_NS_PER_MS;
+}
+
+static void draw_hud(void) {
+    int frames_last_second = 0;
+    Uint64 since = frame_start_ns > SDL_NS_PER_SECOND ? frame_start_ns - SDL_NS_PER_SECOND : 0;
+    for (int i = 0; i < hud_history_len; ++i) {
+        if (hud_history[i].start_ns >= since) frames_last_second++;
+    }
+
+    char lines[4][128];
+    SDL_snprintf(lines[0], sizeof(lines[0]), "FPS %d  frame p50 %.2f  p95 %.2f  p99 %.2f ms",
+                 frames_last_second, frame_time_percentile(0.50f), frame_time_percentile(0.95f), frame_time_percentile(0.99f));
+    SDL_snprintf(lines[1], sizeof(lines[1]), "event %.2f  draw %.2f  present %.2f ms",
+                 hud_event_ns / (double)SDL_NS_PER_MS, hud_draw_ns / (double)SDL_NS_PER_MS, hud_present_ns / (double)SDL_NS_PER_MS);
+    SDL_snprintf(lines[2], sizeof(lines[2]), "textures/frame %d  draw calls %d  upload queue %d",
+                 hud_textures_per_frame, hud_draw_calls_per_frame, upload_backlog);
+    SDL_snprintf(lines[3], sizeof(lines[3]), "covers %llu hit  %llu miss  %llu evicted  %zu KB",
+                 (unsigned long long)cover_hits, (unsigned long long)cover_misses,
+                 (unsigned long long)cover_evictions, cover_cache_bytes / 1024);
+
+    // Flush first so the panel lands on top of whatever the menus queued
+    batch_flush();
+
+    int line_count = (int)(sizeof(lines) / sizeof(lines[0]));
+    SDL_FRect panel = { 6.0f, 6.0f, 460.0f, line_count * (FONT_SIZE + 6) + 8.0f };
+    SDL_Color panel_color = { 0, 0, 0, 255 };
+    SDL_Color text_color = { 120, 255, 120, 255 };
+    batch_fill(&panel, panel_color);
+
+    // The numbers change every frame, so they skip the label cache and come straight from the glyph atlas
+    for (int i = 0; i < line_count; ++i) {
+        draw_text_quads(lines[i], 12.0f, 10.0f + i * (FONT_SIZE + 6), text_color);
+    }
+}
+
+static void profile_add(ProfileCounter *counter, Uint64 start_ns) {
+    counter->ns += SDL_GetTicksNS() - start_ns;
+    counter->calls++;
+}
+
+// Synthetic events go through the same handler as a real joystick, minus the input cooldown
+static void bench_inject(BenchAction action) {
+    SDL_Event event;
+    SDL_zero(event);
+
+    if (action == BENCH_LEAVE_ROMS) {
+        while (in_rom_menu && rom_list && rom_list[selected_rom_index].rom_path) bench_inject(BENCH_UP);
+        action = BENCH_PRESS;
+    }
+
+    if (action == BENCH_PRESS) {
+        event.type = SDL_EVENT_JOYSTICK_BUTTON_DOWN;
+        event.jbutton.button = 0;
+        event.jbutton.down = true;
+    } else {
+        event.type = SDL_EVENT_JOYSTICK_AXIS_MOTION;
+        event.jaxis.axis = 1;
+        event.jaxis.value = action == BENCH_UP ? -32767 : 32767;
+    }
+
+    last_input_time = 0;
+    handle_joystick_input(&event);
+
+    // Entering a system scans in the background; the script walks the complete list as before
+    while (rom_scan) {
+        SDL_Delay(1);
+        pump_rom_scan();
+    }
+    render_frame();
+}
+
+static int compare_u64(const void *a, const void *b) {
+    Uint64 x = *(const Uint64 *)a, y = *(const Uint64 *)b;
+    return (x > y) - (x < y);
+}
+
+static double profile_ms(const ProfileCounter *counter) {
+    return counter->ns / (double)SDL_NS_PER_MS;
+}
+
+// Walks every system: enter it, page down through the ROMs (and their covers), scroll back, leave.
+// Prints a JSON report on stdout.
+static int run_bench(void) {
+    int system_count = (int)(sizeof(systems) / sizeof(SystemEntry));
+    int capacity = 1024, frames = 0;
+    Uint64 *frame_ns = SDL_malloc(capacity * sizeof(Uint64));
+    if (!frame_ns) return 1;
+
+    Uint64 bench_start = SDL_GetTicksNS();
+    Uint64 textures_start = textures_created, draw_calls_start = draw_calls;
+
+    render_frame();
+    for (int sys = 0; sys < system_count; ++sys) {
+        BenchAction script[2 * BENCH_ROM_STEPS + 3];
+        int steps = 0;
+
+        script[steps++] = BENCH_PRESS;
+        for (int i = 0; i < BENCH_ROM_STEPS; ++i) script[steps++] = BENCH_DOWN;
+        for (int i = 0; i < BENCH_ROM_STEPS; ++i) script[steps++] = BENCH_UP;
+        script[steps++] = BENCH_LEAVE_ROMS;
+        script[steps++] = BENCH_DOWN;
+
+        for (int i = 0; i < steps; ++i) {
+            Uint64 start = SDL_GetTicksNS();
+            bench_inject(script[i]);
+
+            if (frames == capacity) {
+                Uint64 *grown = SDL_realloc(frame_ns, capacity * 2 * sizeof(Uint64));
+                if (!grown) break;
+                frame_ns = grown;
+                capacity *= 2;
+            }
+            frame_ns[frames++] = SDL_GetTicksNS() - start;
+
+            SDL_Event event;
+            while (SDL_PollEvent(&event)) handle_events(&event);
+        }
+    }
+
+    Uint64 wall_ns = SDL_GetTicksNS() - bench_start;
+    SDL_qsort(frame_ns, frames, sizeof(Uint64), compare_u64);
+
+    double total_ms = 0.0;
+    for (int i = 0; i < frames; ++i) total_ms += frame_ns[i] / (double)SDL_NS_PER_MS;
+
+    #define BENCH_PCT(p) (frames ? frame_ns[(int)((frames - 1) * (p))] / (double)SDL_NS_PER_MS : 0.0)
+    printf("{\n");
+    printf("  \"video_driver\": \"%s\",\n", SDL_GetCurrentVideoDriver());
+    printf("  \"renderer\": \"%s\",\n", SDL_GetRendererName(renderer));
+    printf("  \"frames\": %d,\n", frames);
+    printf("  \"wall_ms\": %.3f,\n", wall_ns / (double)SDL_NS_PER_MS);
+    printf("  \"frame_ms\": { \"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f },\n",
+           frames ? total_ms / frames : 0.0, BENCH_PCT(0.50), BENCH_PCT(0.95), BENCH_PCT(0.99), BENCH_PCT(1.0));
+    printf("  \"load_rom_list\": { \"calls\": %u, \"total_ms\": %.3f },\n", prof_load_rom_list.calls, profile_ms(&prof_load_rom_list));
+    printf("  \"load_cover_for_rom\": { \"calls\": %u, \"total_ms\": %.3f },\n", prof_load_cover.calls, profile_ms(&prof_load_cover));
+    printf("  \"textures_created\": %llu,\n", (unsigned long long)(textures_created - textures_start));
+    printf("  \"draw_calls\": %llu,\n", (unsigned long long)(draw_calls - draw_calls_start));
+    printf("  \"upload_backlog_peak\": %d,\n", upload_backlog_peak);
+    printf("  \"scan_syscalls\": %d\n", SDL_GetAtomicInt(&scan_syscalls_total));
+    printf("}\n");
+    #undef BENCH_PCT
+
+    SDL_free(frame_ns);
+    return 0;
+}
+
+static TraceRing *trace_ring_for_thread(void) {
+    TraceRing *ring = SDL_GetTLS(&trace_tls);
+    if (ring) return ring;
+
+    int index = SDL_AddAtomicInt(&trace_ring_count, 1);
+    if (index >= TRACE_MAX_THREADS) return NULL;
+
+    ring = SDL_calloc(1, sizeof(TraceRing));
+    if (!ring) return NULL;
+    ring->tid = SDL_GetCurrentThreadID();
+    SDL_snprintf(ring->thread_name, sizeof(ring->thread_name), "%s", index == 0 ? "main" : "worker");
+
+    SDL_SetTLS(&trace_tls, ring, NULL);
+    SDL_SetAtomicPointer((void **)&trace_rings[index], ring);
+    return ring;
+}
+
+static void trace_set_thread_name(const char *name) {
+    if (!trace_enabled) return;
+    TraceRing *ring = trace_ring_for_thread();
+    if (ring) SDL_strlcpy(ring->thread_name, name, sizeof(ring->thread_name));
+}
+
+static Uint64 trace_begin(void) {
+    return trace_enabled ? SDL_GetTicksNS() : 0;
+}
+
+// Spans are closed explicitly, the name must be a string literal since only the pointer is kept
+static void trace_end(const char *name, Uint64 start_ns) {
+    if (!trace_enabled || !start_ns) return;
+
+    TraceRing *ring = trace_ring_for_thread();
+    if (!ring) return;
+
+    Uint64 end_ns = SDL_GetTicksNS();
+    SDL_LockSpinlock(&ring->lock);
+    TraceEvent *ev = &ring->events[ring->head];
+    ev->name = name;
+    ev->start_ns = start_ns;
+    ev->dur_ns = end_ns - start_ns;
+    ring->head = (ring->head + 1) % TRACE_RING_EVENTS;
+    if (ring->count < TRACE_RING_EVENTS) ring->count++;
+    SDL_UnlockSpinlock(&ring->lock);
+}
+
+// Writes every ring as Chrome trace-event JSON, loadable in chrome://tracing or ui.perfetto.dev
+static void trace_dump(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        SDL_Log("Cannot write trace to %s", path);
+        return;
+    }
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    int first = 1;
+    int rings = SDL_GetAtomicInt(&trace_ring_count);
+    if (rings > TRACE_MAX_THREADS) rings = TRACE_MAX_THREADS;
+
+    for (int r = 0; r < rings; ++r) {
+        TraceRing *ring = SDL_GetAtomicPointer((void **)&trace_rings[r]);
+        if (!ring) continue;
+
+        SDL_LockSpinlock(&ring->lock);
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%llu,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", (unsigned long long)ring->tid, ring->thread_name);
+        first = 0;
+
+        Uint32 oldest = (ring->head + TRACE_RING_EVENTS - ring->count) % TRACE_RING_EVENTS;
+        for (Uint32 i = 0; i < ring->count; ++i) {
+            const TraceEvent *ev = &ring->events[(oldest + i) % TRACE_RING_EVENTS];
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f}",
+                    ev->name, (unsigned long long)ring->tid, ev->start_ns / 1000.0, ev->dur_ns / 1000.0);
+        }
+        SDL_UnlockSpinlock(&ring->lock);
+    }
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    SDL_Log("Trace written to %s", path);
+}
+
+static void trace_dump_at_exit(void) {
+    trace_dump(trace_path);
+}
+
+static void handle_events(const SDL_Event *event)
 {
+    if (wake_event_type && event->type == wake_event_type) {
+        request_redraw();
+        return;
+    }
+
     switch (event->type)
     {
     // ... other event types like JOYSTICK_ADDED, JOYSTICK_AXIS_MOTION, etc.
 
+    case SDL_EVENT_RENDER_TARGETS_RESET:
+    case SDL_EVENT_RENDER_DEVICE_RESET:
+        // Target texture contents are lost, labels get composed again on next use
+        clear_label_cache();
+        static_layer_dirty = 1;
+        request_redraw();
+        break;
+
+    case SDL_EVENT_WINDOW_RESIZED:
+    case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+        static_layer_dirty = 1;
+        request_redraw();
+        break;
+
+    case SDL_EVENT_WINDOW_EXPOSED:
+    case SDL_EVENT_WINDOW_RESTORED:
+        request_redraw();
+        break;
+
+    case SDL_EVENT_JOYSTICK_BUTTON_DOWN:
+        if (event->jbutton.button == HUD_COMBO_BUTTON_A || event->jbutton.button == HUD_COMBO_BUTTON_B) {
+            SDL_Joystick *joystick = SDL_GetJoystickFromID(event->jbutton.which);
+            Uint8 other = event->jbutton.button == HUD_COMBO_BUTTON_A ? HUD_COMBO_BUTTON_B : HUD_COMBO_BUTTON_A;
+            if (joystick && SDL_GetJoystickButton(joystick, other)) toggle_hud();
+        }
+        break;
+
     case SDL_EVENT_KEY_DOWN: // This case ensures event->key is valid
-        if (event->key.keycode == SDLK_ESCAPE) {
+        if (event->key.key == SDLK_ESCAPE) {
             //quit = true;
             printf("Escape key pressed! Quitting application.\n");
+        } else if (event->key.key == SDLK_F1 && !event->key.repeat) {
+            toggle_hud();
+        } else if (event->key.key == SDLK_F3 && !event->key.repeat && in_rom_menu) {
+            rom_view_grid = !rom_view_grid;
+            request_redraw();
+        } else if (event->key.key == SDLK_F2 && !event->key.repeat && trace_enabled) {
+            char path[64];
+            SDL_snprintf(path, sizeof(path), "trace-%llu.json", (unsigned long long)SDL_GetTicks());
+            trace_dump(path);
         }
         // ... other keyboard key checks (like SDLK_UP, SDLK_DOWN, SDLK_RETURN)
         break;
@@ -420,22 +2780,47 @@ static void handle_joystick_input(const SDL_Event *event) {
         }
 
         if (direction) {
-            if (in_rom_menu) {
+            if (in_rom_menu && rom_view_grid) {
+                move_grid_selection(0, direction);
+            } else if (in_rom_menu) {
                 selected_rom_index = (selected_rom_index + rom_count + direction) % rom_count;
+                rom_scroll_direction = direction;
             } else {
                 int item_count = system_menu_count;
                 selected_system_index = (selected_system_index + item_count + direction) % item_count;
             }
 
             last_input_time = now;
+            request_redraw();
+        }
+    }
+
+    // The horizontal axis only means something in the grid
+    if (event->type == SDL_EVENT_JOYSTICK_AXIS_MOTION && event->jaxis.axis == 0 && in_rom_menu && rom_view_grid) {
+        int direction = 0;
+        if (event->jaxis.value < -AXIS_DEADZONE) direction = -1;
+        else if (event->jaxis.value > AXIS_DEADZONE) direction = 1;
+
+        if (direction) {
+            move_grid_selection(direction, 0);
+            last_input_time = now;
+            request_redraw();
         }
     }
 
+    if (event->type == SDL_EVENT_JOYSTICK_BUTTON_DOWN && event->jbutton.button == GRID_TOGGLE_BUTTON && in_rom_menu) {
+        rom_view_grid = !rom_view_grid;
+        last_input_time = now;
+        request_redraw();
+        return;
+    }
+
     if (event->type == SDL_EVENT_JOYSTICK_BUTTON_DOWN && event->jbutton.button == 0) {
         if (in_rom_menu) {
             if (!rom_list[selected_rom_index].rom_path) {
                 in_rom_menu = 0;
                 free_rom_list();
+                request_redraw();
                 return;
             }
 
@@ -463,6 +2848,7 @@ static void handle_joystick_input(const SDL_Event *event) {
             }
 
             if (final_rom_path[0] != '\0') {
+                Uint64 trace_start = trace_begin();
                 char cmd[1024];
                 //Mix_PauseMusic();
 
@@ -486,6 +2872,7 @@ static void handle_joystick_input(const SDL_Event *event) {
                 }
 
                 //Mix_ResumeMusic();
+                trace_end("launch_mame", trace_start);
             }
 
             in_rom_menu = 0;
@@ -503,8 +2890,10 @@ static void handle_joystick_input(const SDL_Event *event) {
                     perror("Failed to exec cover-scraper");
                     _exit(1);
                 } else if (pid > 0) {
+                    Uint64 trace_start = trace_begin();
                     int status;
                     waitpid(pid, &status, 0);
+                    trace_end("cover_scraper", trace_start);
                 } else {
                     perror("Failed to fork");
                 }
@@ -513,19 +2902,426 @@ static void handle_joystick_input(const SDL_Event *event) {
                 in_rom_menu = 1;
                 selected_rom_index = 0;
                 rom_scroll_offset = 0;
+                grid_scroll_row = 0;
+                rom_scroll_direction = 1;
             }
         }
         
         last_input_time = now;
+        request_redraw();
     }
 }
 
-static int file_exists(const char *path) {
-    struct stat st;
-    return (stat(path, &st) == 0);
+static void init_cover_cache(void) {
+    placeholder_texture = load_texture("assets/cover.png");
+    SDL_memset(cover_cache, 0, sizeof(cover_cache));
+    cover_cache_bytes = 0;
+    cover_done_mutex = SDL_CreateMutex();
+    cover_files_lock = SDL_CreateRWLock();
+}
+
+static void free_cover_entry(CoverEntry *e) {
+    // An in-flight decode is only flagged here; its request comes back through the done list and is freed there
+    if (e->request) SDL_SetAtomicInt(&e->request->cancelled, 1);
+    if (e->texture) SDL_DestroyTexture(e->texture);
+    SDL_free(e->rom_path);
+    cover_cache_bytes -= e->bytes;
+    SDL_memset(e, 0, sizeof(CoverEntry));
+}
+
+// Must run after shutdown_workers(), when no decode can still be in flight
+static void free_cover_cache(void) {
+    SDL_Log("Cover cache: %llu hits, %llu misses, %llu prefetched, %llu evictions, %llu cancelled, %zu KB resident, upload queue peak %d",
+            (unsigned long long)cover_hits, (unsigned long long)cover_misses, (unsigned long long)cover_prefetches,
+            (unsigned long long)cover_evictions, (unsigned long long)cover_cancelled, cover_cache_bytes / 1024,
+            upload_backlog_peak);
+
+    for (int i = 0; i < COVER_CACHE_ENTRIES; ++i) {
+        if (cover_cache[i].rom_path) free_cover_entry(&cover_cache[i]);
+    }
+    pump_cover_uploads();
+
+    if (placeholder_texture) {
+        SDL_DestroyTexture(placeholder_texture);
+        placeholder_texture = NULL;
+    }
+    SDL_DestroyMutex(cover_done_mutex);
+    cover_done_mutex = NULL;
+    free_cover_index();
+    SDL_DestroyRWLock(cover_files_lock);
+    cover_files_lock = NULL;
+}
+
+// Least recently used entry that is not referenced by the batch of the current frame. Uploads run
+// before the draw pass marks this frame's covers, so whatever the previous frame drew is kept too.
+static CoverEntry *lru_cover(int with_texture, const CoverEntry *keep) {
+    CoverEntry *victim = NULL;
+    for (int i = 0; i < COVER_CACHE_ENTRIES; ++i) {
+        CoverEntry *e = &cover_cache[i];
+        if (!e->rom_path || e == keep || e->last_frame + 1 >= frame_serial) continue;
+        if (with_texture && !e->texture) continue;
+        if (!victim || e->last_used < victim->last_used) victim = e;
+    }
+    return victim;
+}
+
+static CoverEntry *alloc_cover_entry(void) {
+    for (int i = 0; i < COVER_CACHE_ENTRIES; ++i) {
+        if (!cover_cache[i].rom_path) return &cover_cache[i];
+    }
+
+    CoverEntry *victim = lru_cover(0, NULL);
+    if (victim) {
+        if (victim->request) cover_cancelled++;
+        else cover_evictions++;
+        free_cover_entry(victim);
+    }
+    return victim;
+}
+
+// Evicts resident textures until `incoming` more bytes fit in the budget
+static void trim_covers(size_t incoming, const CoverEntry *keep) {
+    while (cover_cache_bytes + incoming > cover_budget_bytes) {
+        CoverEntry *victim = lru_cover(1, keep);
+        if (!victim) return;
+        free_cover_entry(victim);
+        cover_evictions++;
+    }
+}
+
+// Smallest level that still covers a square of the given size, so nothing gets magnified
+static int cover_level_for(float size) {
+    int level = 0;
+    while (level + 1 < COVER_LEVELS && (COVER_SIZE >> (level + 1)) >= size) level++;
+    return level;
+}
+
+// Returns the cover for a ROM, or the shared placeholder while it is decoding or when it has none.
+// Missing covers are remembered as negative entries, so holding a selection costs no filesystem
+// access or decode. Prefetch lookups keep their entries alive without counting as hits or misses.
+static SDL_Texture *get_cover(const char *rom_path, int level, int prefetch) {
+    Uint32 hash = SDL_murmur3_32(rom_path, SDL_strlen(rom_path), 0);
+    CoverEntry *match = NULL, *other_level = NULL;
+
+    for (int i = 0; i < COVER_CACHE_ENTRIES; ++i) {
+        CoverEntry *e = &cover_cache[i];
+        if (!e->rom_path || e->hash != hash || SDL_strcmp(e->rom_path, rom_path) != 0) continue;
+        if (e->level == level) match = e;
+        else if (e->texture) other_level = e;
+    }
+
+    // Until this level is resident, another level of the same cover beats the placeholder.
+    // It is pinned to this frame first, so the allocation below cannot evict it.
+    SDL_Texture *interim = placeholder_texture;
+    if (other_level && !prefetch) {
+        other_level->last_used = ++cover_clock;
+        other_level->last_frame = frame_serial;
+        interim = other_level->texture;
+    }
+
+    if (match) {
+        match->last_used = ++cover_clock;
+        match->last_frame = frame_serial;
+        if (!prefetch) cover_hits++;
+        return match->texture ? match->texture : interim;
+    }
+
+    if (prefetch) cover_prefetches++;
+    else cover_misses++;
+    CoverEntry *e = alloc_cover_entry();
+    if (!e) return interim;   // everything resident is on screen right now
+
+    CoverRequest *req = SDL_calloc(1, sizeof(CoverRequest));
+    if (!req) return interim;
+    req->rom_path = SDL_strdup(rom_path);
+    req->level = level;
+    req->entry = e;
+
+    e->rom_path = SDL_strdup(rom_path);
+    e->hash = hash;
+    e->level = level;
+    e->request = req;
+    e->last_used = ++cover_clock;
+    e->last_frame = frame_serial;
+
+    submit_job(decode_cover_job, discard_cover_job, req);
+    return interim;
+}
+
+// Queues decodes for the entries past [first, last) in the direction the selection is moving and a
+// few behind it, so covers are resident by the time they scroll in. Entries that leave the window
+// are cancelled by cancel_stale_covers(). The window shrinks when the budget could not hold it.
+static void prefetch_covers(int first, int last, int ahead, int behind, int level) {
+    if (rom_count <= 1) return;
+
+    int resident = 0;
+    for (int i = 0; i < COVER_CACHE_ENTRIES; ++i) {
+        if (cover_cache[i].texture) resident++;
+    }
+    size_t avg_bytes = resident ? cover_cache_bytes / resident : 0;
+
+    if (avg_bytes) {
+        // Slots stay reserved for the covers on screen
+        size_t fit = cover_budget_bytes / avg_bytes;
+        int room = fit > (size_t)(last - first) ? (int)(fit - (size_t)(last - first)) : 0;
+        if (ahead > room) ahead = room;
+        if (behind > room - ahead) behind = room - ahead;
+    }
+
+    for (int k = 1; k <= ahead + behind; ++k) {
+        int forward = (k <= ahead) == (rom_scroll_direction > 0);
+        int step = k <= ahead ? k : k - ahead;
+        int index = forward ? last - 1 + step : first - step;
+        index = (index % rom_count + rom_count) % rom_count;
+        if (rom_list[index].rom_path) get_cover(rom_list[index].rom_path, level, 1);
+    }
+}
+
+// Worker side: file probing, decode and pixel conversion all happen off the render thread
+static void decode_cover_job(void *userdata) {
+    CoverRequest *req = userdata;
+
+    if (!SDL_GetAtomicInt(&req->cancelled)) {
+        Uint64 start = SDL_GetTicksNS();
+        req->surface = load_cover_for_rom(req->rom_path, req->level);
+        req->decode_ns = SDL_GetTicksNS() - start;
+        req->decoded = 1;
+        trace_end("load_cover_for_rom", start);
+    }
+
+    // Cancelled and coverless requests change nothing on screen; they are drained with the next frame
+    // anyway. Decided before the hand-off, after which the main thread may free req.
+    int visible = req->decoded && req->surface && !SDL_GetAtomicInt(&req->cancelled);
+    discard_cover_job(req);
+    if (visible) wake_main_loop();
+}
+
+// Hands a request back to the main thread, which owns freeing it
+static void discard_cover_job(void *userdata) {
+    CoverRequest *req = userdata;
+    SDL_LockMutex(cover_done_mutex);
+    req->next = cover_done;
+    cover_done = req;
+    SDL_UnlockMutex(cover_done_mutex);
+}
+
+// Main thread: turns finished decodes into textures and drops the ones nobody wants anymore. Runs
+// before drawing, so only a backlog left for later frames asks for another redraw.
+static void pump_cover_uploads(void) {
+    SDL_LockMutex(cover_done_mutex);
+    CoverRequest *done = cover_done;
+    cover_done = NULL;
+    SDL_UnlockMutex(cover_done_mutex);
+
+    // cover_done is a stack, reversing it queues uploads in completion order
+    CoverRequest *ordered = NULL;
+    while (done) {
+        CoverRequest *next = done->next;
+        done->next = ordered;
+        ordered = done;
+        done = next;
+    }
+    if (ordered) {
+        if (upload_tail) upload_tail->next = ordered;
+        else upload_head = ordered;
+        for (upload_tail = ordered; upload_tail->next; upload_tail = upload_tail->next) {}
+    }
+
+    // Cancelled and coverless requests cost nothing and are always drained. The first upload of a
+    // frame ignores the byte limit so a single large cover can never get stuck.
+    CoverRequest *req = upload_head;
+    upload_head = upload_tail = NULL;
+    upload_backlog = 0;
+    int uploads = 0;
+    size_t uploaded_bytes = 0;
+
+    while (req) {
+        CoverRequest *next = req->next;
+        int live = !SDL_GetAtomicInt(&req->cancelled) && req->entry->request == req;
+
+        if (live && req->surface) {
+            size_t bytes = (size_t)req->surface->w * (size_t)req->surface->h * 4;
+            if (uploads && (uploads >= UPLOAD_MAX_PER_FRAME || uploaded_bytes + bytes > UPLOAD_MAX_KB_PER_FRAME * 1024)) {
+                req->next = NULL;
+                if (upload_tail) upload_tail->next = req;
+                else upload_head = req;
+                upload_tail = req;
+                upload_backlog++;
+                req = next;
+                continue;
+            }
+            uploads++;
+            uploaded_bytes += bytes;
+        }
+
+        complete_cover_request(req);
+        req = next;
+    }
+
+    if (upload_backlog > upload_backlog_peak) upload_backlog_peak = upload_backlog;
+    if (upload_backlog) request_redraw();
+}
+
+static void complete_cover_request(CoverRequest *req) {
+    CoverEntry *e = req->entry;
+
+    if (req->decoded) {
+        prof_load_cover.ns += req->decode_ns;
+        prof_load_cover.calls++;
+    }
+
+    if (!SDL_GetAtomicInt(&req->cancelled) && e->request == req) {
+        e->request = NULL;
+        if (req->surface) {
+            size_t bytes = (size_t)req->surface->w * (size_t)req->surface->h * 4;
+            trim_covers(bytes, e);
+            e->texture = texture_from_surface(req->surface);
+            if (e->texture) {
+                e->bytes = bytes;
+                cover_cache_bytes += bytes;
+            }
+        }
+    }
+
+    if (req->surface) SDL_DestroySurface(req->surface);
+    SDL_free(req->rom_path);
+    SDL_free(req);
+}
+
+// Pending decodes that were not asked for in the frame just drawn belong to rows the user
+// already scrolled past; cancelling them frees the workers for the current selection
+static void cancel_stale_covers(void) {
+    for (int i = 0; i < COVER_CACHE_ENTRIES; ++i) {
+        CoverEntry *e = &cover_cache[i];
+        if (e->rom_path && e->request && e->last_frame != frame_serial) {
+            free_cover_entry(e);
+            cover_cancelled++;
+        }
+    }
+}
+
+static void init_workers(void) {
+    job_mutex = SDL_CreateMutex();
+    job_cond = SDL_CreateCondition();
+
+    worker_count = SDL_GetNumLogicalCPUCores() - 1;
+    if (worker_count < 1) worker_count = 1;
+    if (worker_count > WORKER_THREADS_MAX) worker_count = WORKER_THREADS_MAX;
+    background_limit = SDL_max(worker_count - 1, 1);
+
+    for (int i = 0; i < worker_count; ++i) {
+        workers[i] = SDL_CreateThread(worker_main, "worker", NULL);
+        if (!workers[i]) {
+            SDL_Log("Failed to start worker thread: %s", SDL_GetError());
+            worker_count = i;
+            break;
+        }
+    }
+}
+
+static int worker_main(void *data) {
+    trace_set_thread_name("worker");
+
+    for (;;) {
+        SDL_LockMutex(job_mutex);
+        while (!job_head && !(background_head && background_running < background_limit) && !workers_quit) {
+            SDL_WaitCondition(job_cond, job_mutex);
+        }
+        if (workers_quit) {
+            SDL_UnlockMutex(job_mutex);
+            return 0;
+        }
+
+        Job *job;
+        if (job_head) {
+            job = job_head;
+            job_head = job->next;
+            if (!job_head) job_tail = NULL;
+        } else {
+            job = background_head;
+            background_head = job->next;
+            if (!background_head) background_tail = NULL;
+            background_running++;
+        }
+        SDL_UnlockMutex(job_mutex);
+
+        job->run(job->userdata);
+
+        if (job->background) {
+            SDL_LockMutex(job_mutex);
+            background_running--;
+            SDL_SignalCondition(job_cond);
+            SDL_UnlockMutex(job_mutex);
+        }
+        SDL_free(job);
+    }
+}
+
+static void submit_job(JobFn run, JobFn discard, void *userdata) {
+    queue_job(run, discard, userdata, 0);
+}
+
+// For work nobody is waiting on, like the startup pre-scan
+static void submit_background_job(JobFn run, JobFn discard, void *userdata) {
+    queue_job(run, discard, userdata, 1);
+}
+
+// Without any worker thread the job runs inline, which keeps behaviour correct on single-core boxes
+static void queue_job(JobFn run, JobFn discard, void *userdata, int background) {
+    if (!worker_count) {
+        run(userdata);
+        return;
+    }
+
+    Job *job = SDL_malloc(sizeof(Job));
+    if (!job) {
+        if (discard) discard(userdata);
+        return;
+    }
+    job->run = run;
+    job->discard = discard;
+    job->userdata = userdata;
+    job->background = background;
+    job->next = NULL;
+
+    Job **head = background ? &background_head : &job_head;
+    Job **tail = background ? &background_tail : &job_tail;
+    SDL_LockMutex(job_mutex);
+    if (*tail) (*tail)->next = job;
+    else *head = job;
+    *tail = job;
+    SDL_SignalCondition(job_cond);
+    SDL_UnlockMutex(job_mutex);
+}
+
+// Stops the workers after their current job; queued jobs are discarded, not run
+static void shutdown_workers(void) {
+    SDL_LockMutex(job_mutex);
+    workers_quit = 1;
+    SDL_BroadcastCondition(job_cond);
+    SDL_UnlockMutex(job_mutex);
+
+    for (int i = 0; i < worker_count; ++i) SDL_WaitThread(workers[i], NULL);
+    worker_count = 0;
+
+    if (job_tail) job_tail->next = background_head;
+    else job_head = background_head;
+    background_head = background_tail = NULL;
+
+    while (job_head) {
+        Job *job = job_head;
+        job_head = job->next;
+        if (job->discard) job->discard(job->userdata);
+        SDL_free(job);
+    }
+    job_tail = NULL;
+
+    SDL_DestroyCondition(job_cond);
+    SDL_DestroyMutex(job_mutex);
 }
 
-static SDL_Texture *load_cover_for_rom(const char *rom_path) {
+// Runs on a worker thread: returns the cover as an ARGB8888 thumbnail ready to upload
+static SDL_Surface *load_cover_for_rom(const char *rom_path, int level) {
     if (!rom_path) return NULL;
 
     const char *filename = strrchr(rom_path, '/');
@@ -535,20 +3331,633 @@ static SDL_Texture *load_cover_for_rom(const char *rom_path) {
     int base_len = dot ? (int)(dot - filename) : (int)strlen(filename);
 
     char cover_path[512];
-    SDL_Texture *tex = NULL;
+    Sint64 src_mtime, src_size;
+    if (!find_cover_file(filename, base_len, cover_path, sizeof(cover_path), &src_mtime, &src_size)) return NULL;
+
+    SDL_Surface *surface = NULL;
+    const PackIndexEntry *packed = find_packed_cover(filename, base_len);
+    if (packed) surface = packed_cover_surface(packed, src_mtime, src_size);
+    if (!surface) surface = load_thumb(cover_path, filename, base_len, src_mtime, src_size);
+
+    // Smaller levels are halved step by step from the full thumbnail; each 2:1 linear pass
+    // averages 2x2 blocks, so small tiles do not alias the way a single big step would
+    for (int l = 1; surface && l <= level; ++l) {
+        int size = COVER_SIZE >> l;
+        SDL_Surface *half = SDL_ScaleSurface(surface, size, size, SDL_SCALEMODE_LINEAR);
+        SDL_DestroySurface(surface);
+        surface = half;
+    }
+    return surface;
+}
+
+// Thumbnail files: a small header followed by tightly packed ARGB8888 rows. The header keeps the
+// source file's mtime and size, so a replaced cover invalidates its thumbnail on the next read.
+static int read_thumb_header(SDL_IOStream *io, Uint32 *w, Uint32 *h, Sint64 *mtime, Sint64 *size) {
+    Uint32 magic, reserved;
+
+    if (!SDL_ReadU32LE(io, &magic) || magic != THUMB_MAGIC) return 0;
+    if (!SDL_ReadU32LE(io, w) || !SDL_ReadU32LE(io, h) || !SDL_ReadU32LE(io, &reserved)) return 0;
+    if (!SDL_ReadS64LE(io, mtime) || !SDL_ReadS64LE(io, size)) return 0;
+    return *w > 0 && *h > 0 && *w <= THUMB_MAX_DIM && *h <= THUMB_MAX_DIM;
+}
+
+static SDL_Surface *read_thumb(SDL_IOStream *io, Sint64 src_mtime, Sint64 src_size) {
+    Uint32 w, h;
+    Sint64 mtime, size;
+
+    if (!read_thumb_header(io, &w, &h, &mtime, &size)) return NULL;
+    if (mtime != src_mtime || size != src_size) return NULL;
+
+    SDL_Surface *surface = SDL_CreateSurface((int)w, (int)h, SDL_PIXELFORMAT_ARGB8888);
+    if (!surface) return NULL;
+
+    size_t row_bytes = (size_t)w * 4;
+    Uint8 *pixels = surface->pixels;
+    if ((size_t)surface->pitch == row_bytes) {
+        if (SDL_ReadIO(io, pixels, row_bytes * h) != row_bytes * h) goto fail;
+    } else {
+        for (Uint32 y = 0; y < h; ++y) {
+            if (SDL_ReadIO(io, pixels + y * surface->pitch, row_bytes) != row_bytes) goto fail;
+        }
+    }
+    return surface;
+
+fail:
+    SDL_DestroySurface(surface);
+    return NULL;
+}
+
+static int write_thumb_io(SDL_IOStream *io, SDL_Surface *thumb, Sint64 src_mtime, Sint64 src_size) {
+    int ok = SDL_WriteU32LE(io, THUMB_MAGIC) && SDL_WriteU32LE(io, (Uint32)thumb->w) &&
+             SDL_WriteU32LE(io, (Uint32)thumb->h) && SDL_WriteU32LE(io, 0) &&
+             SDL_WriteS64LE(io, src_mtime) && SDL_WriteS64LE(io, src_size);
+
+    size_t row_bytes = (size_t)thumb->w * 4;
+    for (int y = 0; ok && y < thumb->h; ++y) {
+        ok = SDL_WriteIO(io, (Uint8 *)thumb->pixels + y * thumb->pitch, row_bytes) == row_bytes;
+    }
+    return ok;
+}
+
+// Written to a temporary name first and renamed, so readers never see a half-written thumbnail
+static void write_thumb(const char *thumb_path, SDL_Surface *thumb, Sint64 src_mtime, Sint64 src_size) {
+    char tmp_path[600];
+    SDL_snprintf(tmp_path, sizeof(tmp_path), "%s.%llu.tmp", thumb_path, (unsigned long long)SDL_GetCurrentThreadID());
+
+    SDL_IOStream *io = SDL_IOFromFile(tmp_path, "wb");
+    if (!io) return;
+
+    int ok = write_thumb_io(io, thumb, src_mtime, src_size);
+    if (!SDL_CloseIO(io)) ok = 0;
+    if (ok) ok = rename(tmp_path, thumb_path) == 0;
+    if (!ok) remove(tmp_path);
+}
+
+// Full decode of the original, converted and scaled to the size the list view draws it at
+static SDL_Surface *make_thumb(const char *src_path) {
+    SDL_Surface *full = load_jpeg_scaled(src_path, COVER_SIZE, COVER_SIZE);
+    if (!full) full = IMG_Load(src_path);
+    if (!full) return NULL;
+
+    SDL_Surface *converted = full;
+    if (full->format != SDL_PIXELFORMAT_ARGB8888) {
+        converted = SDL_ConvertSurface(full, SDL_PIXELFORMAT_ARGB8888);
+        SDL_DestroySurface(full);
+        if (!converted) return NULL;
+    }
+
+    if (converted->w == COVER_SIZE && converted->h == COVER_SIZE) return converted;
+
+    SDL_Surface *thumb = SDL_ScaleSurface(converted, COVER_SIZE, COVER_SIZE, SDL_SCALEMODE_LINEAR);
+    SDL_DestroySurface(converted);
+    return thumb;
+}
+
+// libjpeg-turbo can scale in the DCT while decoding. This picks the smallest of 1/1, 1/2, 1/4 and
+// 1/8 that still covers the target, so the full-size image never exists in memory. NULL when
+// built without HAVE_TURBOJPEG or for anything that is not a JPEG; callers fall back to IMG_Load.
+static SDL_Surface *load_jpeg_scaled(const char *path, int target_w, int target_h) {
+#ifdef HAVE_TURBOJPEG
+    const char *dot = strrchr(path, '.');
+    if (!dot || (SDL_strcasecmp(dot, ".jpg") != 0 && SDL_strcasecmp(dot, ".jpeg") != 0)) return NULL;
+
+    size_t size;
+    unsigned char *data = SDL_LoadFile(path, &size);
+    if (!data) return NULL;
+
+    SDL_Surface *surface = NULL;
+    tjhandle tj = tjInitDecompress();
+    int w, h, subsamp, colorspace;
+    if (!tj || tjDecompressHeader3(tj, data, (unsigned long)size, &w, &h, &subsamp, &colorspace) != 0) goto done;
+
+    tjscalingfactor scale = { 1, 1 };
+    for (int denom = 2; denom <= 8; denom *= 2) {
+        tjscalingfactor next = { 1, denom };
+        if (TJSCALED(w, next) < target_w || TJSCALED(h, next) < target_h) break;
+        scale = next;
+    }
+
+    int scaled_w = TJSCALED(w, scale), scaled_h = TJSCALED(h, scale);
+    surface = SDL_CreateSurface(scaled_w, scaled_h, SDL_PIXELFORMAT_BGRA32);
+    if (!surface) goto done;
+
+    // BGRA byte order is SDL's ARGB8888 on little-endian targets; the alpha byte is written as 0xFF
+    if (tjDecompress2(tj, data, (unsigned long)size, surface->pixels, scaled_w, surface->pitch, scaled_h,
+                      TJPF_BGRA, TJFLAG_FASTDCT) != 0) {
+        SDL_Log("libjpeg-turbo failed on %s: %s", path, tjGetErrorStr2(tj));
+        SDL_DestroySurface(surface);
+        surface = NULL;
+    }
+
+done:
+    if (tj) tjDestroy(tj);
+    SDL_free(data);
+    return surface;
+#else
+    (void)path; (void)target_w; (void)target_h;
+    return NULL;
+#endif
+}
+
+// Returns the thumbnail for a cover source, generating and storing it when missing or stale
+static SDL_Surface *load_thumb(const char *src_path, const char *base, int base_len, Sint64 src_mtime, Sint64 src_size) {
+    char thumb_path[512];
+    snprintf(thumb_path, sizeof(thumb_path), "%s/%.*s.thumb", THUMB_DIR, base_len, base);
+
+    SDL_IOStream *io = SDL_IOFromFile(thumb_path, "rb");
+    if (io) {
+        SDL_Surface *surface = read_thumb(io, src_mtime, src_size);
+        SDL_CloseIO(io);
+        if (surface) return surface;
+    }
+
+    SDL_Surface *thumb = make_thumb(src_path);
+    if (thumb) write_thumb(thumb_path, thumb, src_mtime, src_size);
+    return thumb;
+}
+
+// Tool mode: fills the thumbnail cache for every cover in ./covers and exits
+static int build_thumbnails(void) {
+    DIR *dir = opendir("./covers");
+    if (!dir) {
+        fprintf(stderr, "No ./covers directory\n");
+        return 1;
+    }
+    mkdir(THUMB_DIR, 0755);
+
+    int built = 0, fresh = 0, failed = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        const char *dot = strrchr(entry->d_name, '.');
+        if (!dot || dot == entry->d_name) continue;
+        if (SDL_strcasecmp(dot, ".png") != 0 && SDL_strcasecmp(dot, ".jpg") != 0) continue;
+
+        char src_path[512];
+        snprintf(src_path, sizeof(src_path), "./covers/%s", entry->d_name);
+        struct stat st;
+        if (stat(src_path, &st) == -1 || !S_ISREG(st.st_mode)) continue;
+
+        char thumb_path[512];
+        int base_len = (int)(dot - entry->d_name);
+        snprintf(thumb_path, sizeof(thumb_path), "%s/%.*s.thumb", THUMB_DIR, base_len, entry->d_name);
+
+        SDL_IOStream *io = SDL_IOFromFile(thumb_path, "rb");
+        if (io) {
+            SDL_Surface *existing = read_thumb(io, (Sint64)st.st_mtime, (Sint64)st.st_size);
+            SDL_CloseIO(io);
+            if (existing) {
+                SDL_DestroySurface(existing);
+                fresh++;
+                continue;
+            }
+        }
 
-    snprintf(cover_path, sizeof(cover_path), "./covers/%.*s.png", base_len, filename);
-    if (file_exists(cover_path)) {
-        tex = IMG_LoadTexture(renderer, cover_path);
-        if (tex) return tex;
+        SDL_Surface *thumb = make_thumb(src_path);
+        if (thumb) {
+            write_thumb(thumb_path, thumb, (Sint64)st.st_mtime, (Sint64)st.st_size);
+            SDL_DestroySurface(thumb);
+            built++;
+        } else {
+            failed++;
+        }
+    }
+    closedir(dir);
+
+    printf("Thumbnails: %d built, %d up to date, %d failed\n", built, fresh, failed);
+    return failed ? 1 : 0;
+}
+
+// Maps the cover pack if one was built; covers missing from it fall back to the thumbnail files
+static void open_cover_pack(void) {
+    int fd = open(PACK_PATH, O_RDONLY);
+    if (fd == -1) return;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < PACK_HEADER_SIZE) {
+        close(fd);
+        return;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        SDL_Log("Could not map %s", PACK_PATH);
+        return;
+    }
+
+    Uint32 magic = 0, count = 0;
+    Uint64 index_offset = 0, strings_offset = 0, strings_size = 0;
+    SDL_IOStream *io = SDL_IOFromConstMem(map, PACK_HEADER_SIZE);
+    int ok = io && SDL_ReadU32LE(io, &magic) && SDL_ReadU32LE(io, &count) &&
+             SDL_ReadU64LE(io, &index_offset) && SDL_ReadU64LE(io, &strings_offset) &&
+             SDL_ReadU64LE(io, &strings_size);
+    if (io) SDL_CloseIO(io);
+
+    Uint64 size = (Uint64)st.st_size;
+    ok = ok && magic == PACK_MAGIC && index_offset % 8 == 0 && index_offset <= size &&
+         count <= (size - index_offset) / sizeof(PackIndexEntry) &&
+         strings_offset <= size && strings_size <= size - strings_offset;
+    if (!ok) {
+        SDL_Log("Ignoring invalid cover pack %s", PACK_PATH);
+        munmap(map, (size_t)st.st_size);
+        return;
     }
 
-    snprintf(cover_path, sizeof(cover_path), "./covers/%.*s.jpg", base_len, filename);
-    
-    if (file_exists(cover_path)) {
-        tex = IMG_LoadTexture(renderer, cover_path);
-        if (tex) return tex;
+    cover_pack = map;
+    cover_pack_size = (size_t)st.st_size;
+    cover_pack_index = (const PackIndexEntry *)(cover_pack + index_offset);
+    cover_pack_count = count;
+    cover_pack_strings = (const char *)cover_pack + strings_offset;
+    cover_pack_strings_size = strings_size;
+}
+
+static void close_cover_pack(void) {
+    if (cover_pack) munmap((void *)cover_pack, cover_pack_size);
+    cover_pack = NULL;
+    cover_pack_size = 0;
+    cover_pack_index = NULL;
+    cover_pack_count = 0;
+    cover_pack_strings = NULL;
+    cover_pack_strings_size = 0;
+}
+
+// Binary search for the first entry with the name's hash, then compare names across collisions
+static const PackIndexEntry *find_packed_cover(const char *base, int base_len) {
+    if (!cover_pack_count) return NULL;
+
+    Uint32 hash = SDL_murmur3_32(base, (size_t)base_len, 0);
+    Uint32 lo = 0, hi = cover_pack_count;
+    while (lo < hi) {
+        Uint32 mid = lo + (hi - lo) / 2;
+        if (SDL_Swap32LE(cover_pack_index[mid].hash) < hash) lo = mid + 1;
+        else hi = mid;
     }
 
+    for (; lo < cover_pack_count && SDL_Swap32LE(cover_pack_index[lo].hash) == hash; ++lo) {
+        const PackIndexEntry *entry = &cover_pack_index[lo];
+        Uint32 name_offset = SDL_Swap32LE(entry->name_offset);
+        Uint32 name_len = SDL_Swap32LE(entry->name_len);
+        if (name_len != (Uint32)base_len) continue;
+        if ((Uint64)name_offset + name_len > cover_pack_strings_size) continue;
+        if (memcmp(cover_pack_strings + name_offset, base, name_len) == 0) return entry;
+    }
     return NULL;
 }
+
+// Returns the entry's thumbnail record inside the mapping after checking it stays in bounds
+static const Uint8 *packed_record(const PackIndexEntry *entry, Uint32 *data_size, Uint32 *w, Uint32 *h,
+                                  Sint64 *src_mtime, Sint64 *src_size) {
+    Uint64 offset = SDL_Swap64LE(entry->data_offset);
+    *data_size = SDL_Swap32LE(entry->data_size);
+    if (offset % PACK_ALIGN || offset > cover_pack_size || *data_size > cover_pack_size - offset) return NULL;
+
+    const Uint8 *record = cover_pack + offset;
+    SDL_IOStream *io = SDL_IOFromConstMem(record, *data_size);
+    if (!io) return NULL;
+    int ok = read_thumb_header(io, w, h, src_mtime, src_size);
+    SDL_CloseIO(io);
+
+    if (!ok || (Uint64)*w * *h * 4 > *data_size - THUMB_HEADER_SIZE) return NULL;
+    return record;
+}
+
+// Zero-copy: the surface points straight into the mapping, so the upload reads the page cache.
+// NULL when the record was packed from an older version of the source.
+static SDL_Surface *packed_cover_surface(const PackIndexEntry *entry, Sint64 src_mtime, Sint64 src_size) {
+    Uint32 data_size, w, h;
+    Sint64 packed_mtime, packed_size;
+    const Uint8 *record = packed_record(entry, &data_size, &w, &h, &packed_mtime, &packed_size);
+    if (!record || packed_mtime != src_mtime || packed_size != src_size) return NULL;
+
+    return SDL_CreateSurfaceFrom((int)w, (int)h, SDL_PIXELFORMAT_ARGB8888,
+                                 (void *)(record + THUMB_HEADER_SIZE), (int)(w * 4));
+}
+
+static int SDLCALL compare_pack_entries(void *userdata, const void *a, const void *b) {
+    const PackIndexEntry *ea = a, *eb = b;
+    if (ea->hash != eb->hash) return ea->hash < eb->hash ? -1 : 1;
+
+    const char *strings = userdata;
+    Uint32 len = SDL_min(ea->name_len, eb->name_len);
+    int cmp = memcmp(strings + ea->name_offset, strings + eb->name_offset, len);
+    if (cmp) return cmp;
+    return (int)ea->name_len - (int)eb->name_len;
+}
+
+// Tool mode: packs the thumbnail of every cover in ./covers into PACK_PATH. Records whose source
+// is unchanged are copied from the previous pack, so refreshing after a scrape only decodes new art.
+static int build_cover_pack(void) {
+    DIR *dir = opendir("./covers");
+    if (!dir) {
+        fprintf(stderr, "No ./covers directory\n");
+        return 1;
+    }
+    mkdir(THUMB_DIR, 0755);
+    open_cover_pack();
+
+    const char *tmp_path = PACK_PATH ".tmp";
+    SDL_IOStream *io = SDL_IOFromFile(tmp_path, "wb");
+    if (!io) {
+        fprintf(stderr, "Could not write %s\n", tmp_path);
+        closedir(dir);
+        close_cover_pack();
+        return 1;
+    }
+
+    static const Uint8 zeros[PACK_HEADER_SIZE] = { 0 };
+    PackIndexEntry *index = NULL;
+    char *strings = NULL;
+    Uint32 count = 0, capacity = 0;
+    Uint64 strings_size = 0, strings_capacity = 0;
+    Uint64 offset = PACK_HEADER_SIZE;
+    int reused = 0, packed = 0, failed = 0;
+
+    int ok = SDL_WriteIO(io, zeros, PACK_HEADER_SIZE) == PACK_HEADER_SIZE;
+
+    struct dirent *entry;
+    while (ok && (entry = readdir(dir))) {
+        const char *dot = strrchr(entry->d_name, '.');
+        if (!dot || dot == entry->d_name) continue;
+        int is_png = SDL_strcasecmp(dot, ".png") == 0;
+        if (!is_png && SDL_strcasecmp(dot, ".jpg") != 0) continue;
+
+        int base_len = (int)(dot - entry->d_name);
+        char src_path[512];
+        struct stat st;
+
+        // The menu prefers a .png over a .jpg with the same name
+        if (!is_png) {
+            snprintf(src_path, sizeof(src_path), "./covers/%.*s.png", base_len, entry->d_name);
+            if (stat(src_path, &st) == 0) continue;
+        }
+
+        snprintf(src_path, sizeof(src_path), "./covers/%s", entry->d_name);
+        if (stat(src_path, &st) == -1 || !S_ISREG(st.st_mode)) continue;
+
+        if (count == capacity) {
+            Uint32 new_capacity = capacity ? capacity * 2 : 256;
+            PackIndexEntry *grown = SDL_realloc(index, new_capacity * sizeof(*index));
+            if (!grown) { ok = 0; break; }
+            index = grown;
+            capacity = new_capacity;
+        }
+        if (strings_size + (Uint64)base_len > strings_capacity) {
+            Uint64 new_capacity = strings_capacity ? strings_capacity * 2 : 4096;
+            while (new_capacity < strings_size + (Uint64)base_len) new_capacity *= 2;
+            char *grown = SDL_realloc(strings, (size_t)new_capacity);
+            if (!grown) { ok = 0; break; }
+            strings = grown;
+            strings_capacity = new_capacity;
+        }
+
+        Uint32 data_size = 0, w, h;
+        Sint64 src_mtime, src_size;
+        const PackIndexEntry *old = find_packed_cover(entry->d_name, base_len);
+        const Uint8 *record = old ? packed_record(old, &data_size, &w, &h, &src_mtime, &src_size) : NULL;
+
+        if (record && src_mtime == (Sint64)st.st_mtime && src_size == (Sint64)st.st_size) {
+            ok = SDL_WriteIO(io, record, data_size) == data_size;
+            reused++;
+        } else {
+            SDL_Surface *thumb = load_thumb(src_path, entry->d_name, base_len, (Sint64)st.st_mtime, (Sint64)st.st_size);
+            if (!thumb) {
+                failed++;
+                continue;
+            }
+            ok = write_thumb_io(io, thumb, (Sint64)st.st_mtime, (Sint64)st.st_size);
+            data_size = THUMB_HEADER_SIZE + (Uint32)thumb->w * (Uint32)thumb->h * 4;
+            SDL_DestroySurface(thumb);
+            packed++;
+        }
+
+        index[count++] = (PackIndexEntry){
+            SDL_murmur3_32(entry->d_name, (size_t)base_len, 0), (Uint32)strings_size, (Uint32)base_len, data_size, offset
+        };
+        memcpy(strings + strings_size, entry->d_name, (size_t)base_len);
+        strings_size += (Uint64)base_len;
+
+        offset += data_size;
+        size_t pad = (size_t)((PACK_ALIGN - offset % PACK_ALIGN) % PACK_ALIGN);
+        if (ok && pad) ok = SDL_WriteIO(io, zeros, pad) == pad;
+        offset += pad;
+    }
+    closedir(dir);
+
+    Uint64 strings_offset = offset;
+    if (ok && strings_size) ok = SDL_WriteIO(io, strings, (size_t)strings_size) == strings_size;
+    offset += strings_size;
+
+    size_t pad = (size_t)((8 - offset % 8) % 8);
+    if (ok && pad) ok = SDL_WriteIO(io, zeros, pad) == pad;
+    Uint64 index_offset = offset + pad;
+
+    if (count) SDL_qsort_r(index, count, sizeof(*index), compare_pack_entries, strings);
+    for (Uint32 i = 0; ok && i < count; ++i) {
+        ok = SDL_WriteU32LE(io, index[i].hash) && SDL_WriteU32LE(io, index[i].name_offset) &&
+             SDL_WriteU32LE(io, index[i].name_len) && SDL_WriteU32LE(io, index[i].data_size) &&
+             SDL_WriteU64LE(io, index[i].data_offset);
+    }
+
+    // The header goes in last, so an interrupted build never looks like a valid pack
+    ok = ok && SDL_SeekIO(io, 0, SDL_IO_SEEK_SET) == 0 &&
+         SDL_WriteU32LE(io, PACK_MAGIC) && SDL_WriteU32LE(io, count) &&
+         SDL_WriteU64LE(io, index_offset) && SDL_WriteU64LE(io, strings_offset) &&
+         SDL_WriteU64LE(io, strings_size);
+
+    if (!SDL_CloseIO(io)) ok = 0;
+    close_cover_pack();
+    if (ok) ok = rename(tmp_path, PACK_PATH) == 0;
+    if (!ok) remove(tmp_path);
+
+    SDL_free(index);
+    SDL_free(strings);
+
+    if (!ok) {
+        fprintf(stderr, "Could not write %s\n", PACK_PATH);
+        return 1;
+    }
+    printf("Cover pack: %u covers (%d reused, %d packed, %d failed)\n", count, reused, packed, failed);
+    return failed ? 1 : 0;
+}
+
+// Called at startup and on every system entry. The listing runs as a pool job, so a large ./covers on
+// slow storage never holds up a frame; lookups see the old table (or none) until the new one is swapped in.
+static void refresh_cover_index(void) {
+    if (!SDL_CompareAndSwapAtomicInt(&cover_index_busy, 0, 1)) return;
+    submit_job(cover_index_job, discard_cover_index_job, NULL);
+}
+
+static void discard_cover_index_job(void *userdata) {
+    SDL_SetAtomicInt(&cover_index_busy, 0);
+}
+
+// Runs on a worker: a single stat unless ./covers changed since the last scan
+static void cover_index_job(void *userdata) {
+    struct stat dir_st;
+    int have_dir = stat("./covers", &dir_st) == 0;
+    Sint64 dir_mtime = have_dir ? stat_mtime_ns(&dir_st) : 0;
+    if (cover_dir_mtime != -1 && dir_mtime == cover_dir_mtime) {
+        SDL_SetAtomicInt(&cover_index_busy, 0);
+        return;
+    }
+
+    Uint64 trace_start = trace_begin();
+    CoverFile *found = NULL;
+    Uint32 found_count = 0, found_capacity = 0;
+
+    DIR *dir = have_dir ? opendir("./covers") : NULL;
+    struct dirent *entry;
+    while (dir && (entry = readdir(dir))) {
+        const char *dot = strrchr(entry->d_name, '.');
+        if (!dot || dot == entry->d_name) continue;
+
+        CoverFormat format;
+        if (SDL_strcasecmp(dot, ".png") == 0) format = COVER_FORMAT_PNG;
+        else if (SDL_strcasecmp(dot, ".jpg") == 0) format = COVER_FORMAT_JPG;
+        else continue;
+
+        char path[512];
+        snprintf(path, sizeof(path), "./covers/%s", entry->d_name);
+        struct stat st;
+        if (stat(path, &st) == -1 || !S_ISREG(st.st_mode)) continue;
+
+        if (found_count == found_capacity) {
+            Uint32 new_capacity = found_capacity ? found_capacity * 2 : 256;
+            CoverFile *grown = SDL_realloc(found, new_capacity * sizeof(CoverFile));
+            if (!grown) break;
+            found = grown;
+            found_capacity = new_capacity;
+        }
+
+        int base_len = (int)(dot - entry->d_name);
+        char *file_name = SDL_strdup(entry->d_name);
+        if (!file_name) break;
+        found[found_count++] = (CoverFile){
+            file_name, SDL_murmur3_32(file_name, (size_t)base_len, 0), base_len, format,
+            (Sint64)st.st_mtime, (Sint64)st.st_size
+        };
+    }
+    if (dir) closedir(dir);
+
+    Uint32 capacity = 16;
+    while (capacity < found_count * 2) capacity *= 2;
+    CoverFile *table = SDL_calloc(capacity, sizeof(CoverFile));
+    if (!table) {
+        // Keep the old index; cover_dir_mtime is left alone so the next system entry retries
+        for (Uint32 i = 0; i < found_count; ++i) SDL_free(found[i].file_name);
+        SDL_free(found);
+        SDL_SetAtomicInt(&cover_index_busy, 0);
+        return;
+    }
+
+    Uint32 count = 0;
+    for (Uint32 i = 0; i < found_count; ++i) {
+        CoverFile *f = &found[i];
+        CoverFile *slot = cover_file_slot(table, capacity, f->file_name, f->base_len, f->hash);
+        if (!slot->file_name) {
+            *slot = *f;
+            count++;
+        } else if (f->format < slot->format) {
+            SDL_free(slot->file_name);
+            *slot = *f;
+        } else {
+            SDL_free(f->file_name);
+        }
+    }
+    SDL_free(found);
+
+    // Workers look covers up concurrently, so the table is swapped under the write lock
+    SDL_LockRWLockForWriting(cover_files_lock);
+    CoverFile *old = cover_files;
+    Uint32 old_capacity = cover_files_capacity;
+    cover_files = table;
+    cover_files_capacity = capacity;
+    cover_file_count = count;
+    SDL_UnlockRWLock(cover_files_lock);
+
+    for (Uint32 i = 0; i < old_capacity; ++i) SDL_free(old[i].file_name);
+    SDL_free(old);
+
+    // Like the library index: a folder changed just before this listing may change again without
+    // its mtime moving, so it is listed again on the next refresh
+    SDL_Time now;
+    int racy = !SDL_GetCurrentTime(&now) || dir_mtime > (Sint64)now - LIBRARY_RACY_NS;
+    cover_dir_mtime = racy ? -1 : dir_mtime;
+    trace_end("cover_index", trace_start);
+
+    SDL_SetAtomicInt(&cover_index_changed, 1);
+    SDL_SetAtomicInt(&cover_index_busy, 0);
+    wake_main_loop();
+}
+
+// Main thread, before drawing: covers looked up while the old table was current get another chance
+static void pump_cover_index(void) {
+    if (SDL_CompareAndSwapAtomicInt(&cover_index_changed, 1, 0)) forget_missing_covers();
+}
+
+static void free_cover_index(void) {
+    for (Uint32 i = 0; i < cover_files_capacity; ++i) SDL_free(cover_files[i].file_name);
+    SDL_free(cover_files);
+    cover_files = NULL;
+    cover_files_capacity = 0;
+    cover_file_count = 0;
+    cover_dir_mtime = -1;
+}
+
+// Linear probe; returns the matching slot or the free slot where the basename would go
+static CoverFile *cover_file_slot(CoverFile *table, Uint32 capacity, const char *base, int base_len, Uint32 hash) {
+    for (Uint32 i = hash & (capacity - 1);; i = (i + 1) & (capacity - 1)) {
+        CoverFile *slot = &table[i];
+        if (!slot->file_name) return slot;
+        if (slot->hash == hash && slot->base_len == base_len && memcmp(slot->file_name, base, (size_t)base_len) == 0) {
+            return slot;
+        }
+    }
+}
+
+// Runs on workers; the path is copied out under the read lock because a rescan may free the table
+static int find_cover_file(const char *base, int base_len, char *path, size_t path_size, Sint64 *mtime, Sint64 *size) {
+    int found = 0;
+    SDL_LockRWLockForReading(cover_files_lock);
+    if (cover_file_count) {
+        Uint32 hash = SDL_murmur3_32(base, (size_t)base_len, 0);
+        CoverFile *slot = cover_file_slot(cover_files, cover_files_capacity, base, base_len, hash);
+        if (slot->file_name) {
+            snprintf(path, path_size, "./covers/%s", slot->file_name);
+            *mtime = slot->mtime;
+            *size = slot->size;
+            found = 1;
+        }
+    }
+    SDL_UnlockRWLock(cover_files_lock);
+    return found;
+}
+
+// After a rescan, ROMs cached as having no cover get another chance (e.g. after the scraper ran,
+// or when they were looked up before the first index was ready)
+static void forget_missing_covers(void) {
+    for (int i = 0; i < COVER_CACHE_ENTRIES; ++i) {
+        CoverEntry *e = &cover_cache[i];
+        if (e->rom_path && !e->texture && !e->request) free_cover_entry(e);
+    }
+}